@@ -6,19 +6,23 @@
 #include <iomanip>
 #include <iostream>
 
-Grid2D::Grid2D(Index beg, Index end)
+template <typename T>
+BasicGrid2D<T>::BasicGrid2D(Index beg, Index end)
   : size_x(end.x + 2)
   , size_y(end.y + 2)
   , begin(beg)
   , end(end)
   , range(beg, end)
   , boundary(beg, end)
-  , _data(size_x * size_y, 0.) {
-    // uint32_t size = std::bit_width(x) + std::bit_width(y);
-    // this->_data.resize(1 << size, 0.);
-    // this->_data.resize(x * y, init);
-  };
-Grid2D::Grid2D(Index beg, Index end, Range globalRange)
+  , _data(size_x * size_y)
+{
+  first_touch();
+  // uint32_t size = std::bit_width(x) + std::bit_width(y);
+  // this->_data.resize(1 << size, 0.);
+  // this->_data.resize(x * y, init);
+};
+template <typename T>
+BasicGrid2D<T>::BasicGrid2D(Index beg, Index end, Range globalRange)
   : size_x(end.x + 2)
   , size_y(end.y + 2)
   , begin(beg)
@@ -26,20 +30,37 @@ Grid2D::Grid2D(Index beg, Index end, Range globalRange)
   , range(beg, end)
   , globalRange(globalRange)
   , boundary(beg, end)
-  , _data(size_x * size_y, 0.) {
-    // uint32_t size = std::bit_width(x) + std::bit_width(y);
-    // this->_data.resize(1 << size, 0.);
-    // this->_data.resize(x * y, init);
-  };
+  , _data(size_x * size_y)
+{
+  first_touch();
+  // uint32_t size = std::bit_width(x) + std::bit_width(y);
+  // this->_data.resize(1 << size, 0.);
+  // this->_data.resize(x * y, init);
+};
+
+// the rows are zeroed with the static schedule of the sweeps, so their pages are placed on the
+// NUMA node of the thread that works on them
+template <typename T>
+void BasicGrid2D<T>::first_touch()
+{
+#pragma omp parallel for schedule(static) if (_data.size() >= PARALLEL_CELLS)
+  for (uint16_t j = 0; j < size_y; j++)
+  {
+    std::fill_n(_data.data() + j * size_x, size_x, T(0));
+  }
+}
 
-double& Grid2D::operator[](uint32_t index) { return this->_data.data()[index]; };
+template <typename T>
+T& BasicGrid2D<T>::operator[](uint32_t index) { return this->_data.data()[index]; };
 
-const double& Grid2D::operator[](uint32_t index) const
+template <typename T>
+const T& BasicGrid2D<T>::operator[](uint32_t index) const
 {
   return this->_data.data()[index];
 };
 
-std::ostream& operator<<(std::ostream& os, const Grid2D& obj)
+template <typename T>
+std::ostream& operator<<(std::ostream& os, const BasicGrid2D<T>& obj)
 {
   os << std::scientific << std::setprecision(3) << std::endl;
   os << (obj.end.x - obj.begin.x + 1) << "x" << (obj.end.y - obj.begin.y + 1) << " Grid2D" << std::endl;
@@ -98,6 +119,11 @@ std::ostream& operator<<(std::ostream& os, const Grid2D& obj)
 
   return os;
 }
+
+template class BasicGrid2D<double>;
+template class BasicGrid2D<float>;
+template std::ostream& operator<<(std::ostream& os, const Grid2D& obj);
+template std::ostream& operator<<(std::ostream& os, const Grid2DFloat& obj);
 // bool boundary(uint32_t zindex, uint16_t sx, uint16_t sy)
 //{
 //   auto [x, y] = decode_z_order(zindex);
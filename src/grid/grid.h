@@ -6,6 +6,7 @@
 #include <cstdint>
 #include <execution>
 #include <iostream>
+#include <memory>
 #include <mpi.h>
 #include <ostream>
 #include <type_traits>
@@ -15,6 +16,7 @@
 #include "indexing.h"
 #include "utils/Logger.h"
 #include "utils/index.h"
+#include "utils/partitioning.h"
 
 #define CARTESIAN
 
@@ -49,10 +51,45 @@ struct Boundaries
   };
 };
 
-class Grid2D
+// grids and sweeps with fewer cells stay on the calling thread, a parallel region costs more than they do
+constexpr size_t PARALLEL_CELLS = 4096;
+
+// allocator that leaves the elements uninitialized, the grid writes them first from the threads
+// that sweep them later
+template <typename T>
+struct FirstTouchAllocator : std::allocator<T>
+{
+  using value_type = T;
+  FirstTouchAllocator() = default;
+  template <typename U>
+  FirstTouchAllocator(const FirstTouchAllocator<U>&) noexcept { }
+  template <typename U>
+  struct rebind
+  {
+    using other = FirstTouchAllocator<U>;
+  };
+  template <typename U>
+  void construct(U* p) noexcept { ::new (static_cast<void*>(p)) U; }
+  template <typename U, typename... Args>
+  void construct(U* p, Args&&... args) { ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...); }
+};
+
+// MPI datatype of the grid elements
+template <typename T>
+inline MPI_Datatype mpi_type();
+template <>
+inline MPI_Datatype mpi_type<double>() { return MPI_DOUBLE; }
+template <>
+inline MPI_Datatype mpi_type<float>() { return MPI_FLOAT; }
+
+// grid of cell values of type T, Grid2D holds doubles, Grid2DFloat the single precision copies
+// used by the mixed precision pressure solve
+template <typename T>
+class BasicGrid2D
 {
 
 public:
+  using value_type = T;
   uint16_t size_x;
   uint16_t size_y;
   Index begin;
@@ -61,21 +98,27 @@ public:
   Range globalRange;
   Boundaries boundary;
 
-  Grid2D(Index beg, Index end);
-  Grid2D(Index beg, Index end, Range globalRange);
+  BasicGrid2D(Index beg, Index end);
+  BasicGrid2D(Index beg, Index end, Range globalRange);
 
-  Grid2D(const Grid2D&) = delete;
-  Grid2D& operator=(const Grid2D&) = delete;
+  BasicGrid2D(const BasicGrid2D&) = delete;
+  BasicGrid2D& operator=(const BasicGrid2D&) = delete;
 
-  Grid2D(Grid2D&& other) noexcept
-    : boundary(other.boundary)
+  BasicGrid2D(BasicGrid2D&& other) noexcept
+    : size_x(0)
+    , size_y(0)
+    , begin(other.begin)
+    , end(other.end)
+    , range(other.range)
+    , globalRange(other.globalRange)
+    , boundary(other.boundary)
   {
     std::swap(size_x, other.size_x);
     std::swap(size_y, other.size_y);
     std::swap(_data, other._data);
   }
 
-  Grid2D& operator=(Grid2D&& other) noexcept
+  BasicGrid2D& operator=(BasicGrid2D&& other) noexcept
   {
     std::swap(size_x, other.size_x);
     std::swap(size_y, other.size_y);
@@ -85,7 +128,7 @@ public:
 
   // double& operator[](Index index) { return (*this)[index.x + begin.x, index.y + begin.y]; };
   // const double& operator[](Index index) const { return (*this)[index.x + begin.x, index.y + begin.y]; };
-  inline double& operator[](Index I)
+  inline T& operator[](Index I)
   {
 #ifdef CARTESIAN
     uint32_t index = I.x + size_x * I.y;
@@ -100,7 +143,7 @@ public:
 #endif
   };
 
-  inline const double& operator[](Index I) const
+  inline const T& operator[](Index I) const
   {
 #ifdef CARTESIAN
     uint32_t index = I.x + size_x * I.y;
@@ -119,10 +162,14 @@ public:
 #endif
   };
 
-  double& operator[](uint32_t z);
-  const double& operator[](uint32_t z) const;
+  T& operator[](uint32_t z);
+  const T& operator[](uint32_t z) const;
+
+  // pointer to cell I, the cells to its east follow contiguously
+  inline T* row(Index I) { return _data.data() + I.x + size_x * I.y; }
+  inline const T* row(Index I) const { return _data.data() + I.x + size_x * I.y; }
 
-  void get(double* buffer, Range r) const
+  void get(T* buffer, Range r) const
   {
     assert(r.begin.x >= begin.x - 1);
     assert(r.begin.y >= begin.y - 1);
@@ -138,7 +185,7 @@ public:
       }
     }
   };
-  inline void set(double* buffer, Range r)
+  inline void set(T* buffer, Range r)
   {
     assert(r.begin.x >= begin.x - 1);
     assert(r.begin.y >= begin.y - 1);
@@ -157,11 +204,13 @@ public:
   };
 
   const uint32_t elements() const { return this->_data.size(); }
-  inline double max()
+  // ghosts included
+  void fill(T value) { std::fill(_data.begin(), _data.end(), value); }
+  inline T max()
   {
-    double local_max = *std::max_element(_data.begin(), _data.end());
-    double global_max = 0.;
-    MPI_Allreduce(&local_max, &global_max, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    T local_max = *std::max_element(_data.begin(), _data.end());
+    T global_max = 0.;
+    MPI_Allreduce(&local_max, &global_max, 1, mpi_type<T>(), MPI_MAX, Partitioning::getCommunicator());
     return global_max;
     // double result = 0;
 
@@ -176,11 +225,11 @@ public:
     //}
     // return result;
   };
-  inline double min()
+  inline T min()
   {
-    double local_min = *std::min_element(_data.begin(), _data.end());
-    double global_min = 0.;
-    MPI_Allreduce(&local_min, &global_min, 1, MPI_DOUBLE, MPI_MIN, MPI_COMM_WORLD);
+    T local_min = *std::min_element(_data.begin(), _data.end());
+    T global_min = 0.;
+    MPI_Allreduce(&local_min, &global_min, 1, mpi_type<T>(), MPI_MIN, Partitioning::getCommunicator());
     return global_min;
     // double result = 0;
 
@@ -197,8 +246,16 @@ public:
   };
 
 private:
-  std::vector<double> _data;
+  void first_touch();
+  std::vector<T, FirstTouchAllocator<T>> _data;
 };
-std::ostream& operator<<(std::ostream& os, const Grid2D& obj);
+template <typename T>
+std::ostream& operator<<(std::ostream& os, const BasicGrid2D<T>& obj);
+
+using Grid2D = BasicGrid2D<double>;
+using Grid2DFloat = BasicGrid2D<float>;
+
+extern template class BasicGrid2D<double>;
+extern template class BasicGrid2D<float>;
 
 #endif // GRID_H_
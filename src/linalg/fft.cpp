@@ -0,0 +1,152 @@
+#include "fft.h"
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <numbers>
+#include <utility>
+
+FFT::FFT(size_t n)
+  : n(n)
+  , m(1)
+{
+  bool power_of_two = (n & (n - 1)) == 0;
+  // bluestein needs a cyclic convolution of at least 2n - 1 elements
+  while (m < (power_of_two ? n : 2 * n - 1))
+    m <<= 1;
+
+  roots.resize(m / 2);
+  for (size_t k = 0; k < m / 2; k++)
+  {
+    roots[k] = std::polar(1., -2. * std::numbers::pi * k / m);
+  }
+  if (power_of_two)
+    return;
+
+  chirp.resize(n);
+  for (size_t k = 0; k < n; k++)
+  {
+    // k^2 mod 2n keeps the angle accurate for long transforms
+    chirp[k] = std::polar(1., -std::numbers::pi * ((k * k) % (2 * n)) / n);
+  }
+  chirp_spectrum.assign(m, 0.);
+  chirp_spectrum[0] = std::conj(chirp[0]);
+  for (size_t k = 1; k < n; k++)
+  {
+    chirp_spectrum[k] = std::conj(chirp[k]);
+    chirp_spectrum[m - k] = std::conj(chirp[k]);
+  }
+  radix2(chirp_spectrum.data(), false);
+  work.resize(m);
+}
+
+void FFT::radix2(std::complex<double>* data, bool inverse)
+{
+  for (size_t i = 1, j = 0; i < m; i++)
+  {
+    size_t bit = m >> 1;
+    for (; j & bit; bit >>= 1)
+      j ^= bit;
+    j ^= bit;
+    if (i < j)
+      std::swap(data[i], data[j]);
+  }
+  for (size_t len = 2; len <= m; len <<= 1)
+  {
+    size_t step = m / len;
+    for (size_t i = 0; i < m; i += len)
+    {
+      for (size_t k = 0; k < len / 2; k++)
+      {
+        std::complex<double> w = inverse ? std::conj(roots[k * step]) : roots[k * step];
+        std::complex<double> u = data[i + k];
+        std::complex<double> v = data[i + k + len / 2] * w;
+        data[i + k] = u + v;
+        data[i + k + len / 2] = u - v;
+      }
+    }
+  }
+}
+
+void FFT::forward(std::complex<double>* data)
+{
+  if (chirp.empty())
+  {
+    radix2(data, false);
+    return;
+  }
+  for (size_t k = 0; k < m; k++)
+  {
+    work[k] = (k < n) ? data[k] * chirp[k] : 0.;
+  }
+  radix2(work.data(), false);
+  for (size_t k = 0; k < m; k++)
+  {
+    work[k] *= chirp_spectrum[k];
+  }
+  radix2(work.data(), true);
+  for (size_t k = 0; k < n; k++)
+  {
+    data[k] = work[k] * chirp[k] / static_cast<double>(m);
+  }
+}
+
+void FFT::inverse(std::complex<double>* data)
+{
+  for (size_t k = 0; k < n; k++)
+  {
+    data[k] = std::conj(data[k]);
+  }
+  forward(data);
+  for (size_t k = 0; k < n; k++)
+  {
+    data[k] = std::conj(data[k]) / static_cast<double>(n);
+  }
+}
+
+DCT::DCT(size_t n)
+  : n(n)
+  , fft(n)
+  , twiddle(n)
+  , buffer(n)
+{
+  for (size_t k = 0; k < n; k++)
+  {
+    twiddle[k] = std::polar(1., -std::numbers::pi * k / (2. * n));
+  }
+}
+
+void DCT::forward(double* data)
+{
+  // even samples ascending, odd samples descending
+  for (size_t j = 0; 2 * j < n; j++)
+  {
+    buffer[j] = data[2 * j];
+  }
+  for (size_t j = 0; 2 * j + 1 < n; j++)
+  {
+    buffer[n - 1 - j] = data[2 * j + 1];
+  }
+  fft.forward(buffer.data());
+  for (size_t k = 0; k < n; k++)
+  {
+    data[k] = std::real(twiddle[k] * buffer[k]);
+  }
+}
+
+void DCT::inverse(double* data)
+{
+  buffer[0] = data[0];
+  for (size_t k = 1; k < n; k++)
+  {
+    buffer[k] = std::conj(twiddle[k]) * std::complex<double>(data[k], -data[n - k]);
+  }
+  fft.inverse(buffer.data());
+  for (size_t j = 0; 2 * j < n; j++)
+  {
+    data[2 * j] = std::real(buffer[j]);
+  }
+  for (size_t j = 0; 2 * j + 1 < n; j++)
+  {
+    data[2 * j + 1] = std::real(buffer[n - 1 - j]);
+  }
+}
@@ -0,0 +1,41 @@
+#ifndef FFT_H_
+#define FFT_H_
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+// complex FFT of arbitrary length, radix 2 for powers of two and Bluestein's algorithm otherwise
+struct FFT
+{
+  size_t n;
+  size_t m;
+  std::vector<std::complex<double>> roots;
+  std::vector<std::complex<double>> chirp;
+  std::vector<std::complex<double>> chirp_spectrum;
+  std::vector<std::complex<double>> work;
+
+  FFT(size_t n);
+  void forward(std::complex<double>* data);
+  // normalized, inverse(forward(x)) == x
+  void inverse(std::complex<double>* data);
+
+private:
+  void radix2(std::complex<double>* data, bool inverse);
+};
+
+// unnormalized DCT-II X_k = sum_j x_j cos(pi k (j + 1/2) / n) and its exact inverse,
+// computed with Makhouls reordering through a complex FFT of the same length
+struct DCT
+{
+  size_t n;
+  FFT fft;
+  std::vector<std::complex<double>> twiddle;
+  std::vector<std::complex<double>> buffer;
+
+  DCT(size_t n);
+  void forward(double* data);
+  void inverse(double* data);
+};
+
+#endif // FFT_H_
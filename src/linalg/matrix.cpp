@@ -0,0 +1,134 @@
+#include "matrix.h"
+#include <cstdint>
+#include <vector>
+
+CSRMatrix transpose(const CSRMatrix& A)
+{
+  CSRMatrix T;
+  T.rows = A.cols;
+  T.cols = A.rows;
+  T.row_begin.assign(T.rows + 1, 0);
+  for (int column : A.columns)
+    T.row_begin[column + 1]++;
+  for (int i = 0; i < T.rows; i++)
+    T.row_begin[i + 1] += T.row_begin[i];
+  T.columns.resize(A.columns.size());
+  T.values.resize(A.values.size());
+  std::vector<int> next(T.row_begin.begin(), T.row_begin.end() - 1);
+  for (int i = 0; i < A.rows; i++)
+  {
+    for (int k = A.row_begin[i]; k < A.row_begin[i + 1]; k++)
+    {
+      int n = next[A.columns[k]]++;
+      T.columns[n] = i;
+      T.values[n] = A.values[k];
+    }
+  }
+  return T;
+}
+
+CSRMatrix multiply(const CSRMatrix& A, const CSRMatrix& B)
+{
+  CSRMatrix C;
+  C.rows = A.rows;
+  C.cols = B.cols;
+  C.row_begin.resize(A.rows + 1);
+  // position of column j in the current row of C, positions of earlier rows are below the row start
+  std::vector<int> position(B.cols, -1);
+  for (int i = 0; i < A.rows; i++)
+  {
+    int start = C.columns.size();
+    for (int k = A.row_begin[i]; k < A.row_begin[i + 1]; k++)
+    {
+      double a = A.values[k];
+      int row = A.columns[k];
+      for (int l = B.row_begin[row]; l < B.row_begin[row + 1]; l++)
+      {
+        int j = B.columns[l];
+        if (position[j] < start)
+        {
+          position[j] = C.columns.size();
+          C.columns.push_back(j);
+          C.values.push_back(a * B.values[l]);
+        } else
+          C.values[position[j]] += a * B.values[l];
+      }
+    }
+    C.row_begin[i + 1] = C.columns.size();
+  }
+  return C;
+}
+
+void multiply(const CSRMatrix& A, const double* x, double* y)
+{
+  for (int i = 0; i < A.rows; i++)
+  {
+    double sum = 0.;
+    for (int k = A.row_begin[i]; k < A.row_begin[i + 1]; k++)
+      sum += A.values[k] * x[A.columns[k]];
+    y[i] = sum;
+  }
+}
+
+SparseMatrixOperator::SparseMatrixOperator(const Grid2D& layout, const Gridsize& h, const Partitioning::MPIInfo& partitioning)
+  : range(layout.range)
+  , size_x(layout.size_x)
+  , row_length(layout.range.end.x - layout.range.begin.x + 1)
+{
+  const Range r = range;
+  matrix.rows = r.count();
+  matrix.cols = layout.elements();
+  matrix.row_begin.reserve(matrix.rows + 1);
+  matrix.columns.reserve(5 * matrix.rows);
+  matrix.values.reserve(5 * matrix.rows);
+  auto index = [&](Index I) { return static_cast<int>(I.x + layout.size_x * I.y); };
+  for (uint16_t j = r.begin.y; j <= r.end.y; j++)
+  {
+    for (uint16_t i = r.begin.x; i <= r.end.x; i++)
+    {
+      Index I = { i, j };
+      // a neighbour outside the domain is a neumann ghost equal to the cell itself
+      std::pair<bool, double> neighbours[4] = {
+        { i > r.begin.x || partitioning.left_neighbor >= 0, 1. / h.x_squared },
+        { i < r.end.x || partitioning.right_neighbor >= 0, 1. / h.x_squared },
+        { j > r.begin.y || partitioning.bottom_neighbor >= 0, 1. / h.y_squared },
+        { j < r.end.y || partitioning.top_neighbor >= 0, 1. / h.y_squared },
+      };
+      const Offset offsets[4] = { -Ix, Ix, -Iy, Iy };
+      double diagonal = 0.;
+      for (int n = 0; n < 4; n++)
+      {
+        auto [inside, coupling] = neighbours[n];
+        if (!inside)
+          continue;
+        matrix.columns.push_back(index(I + offsets[n]));
+        matrix.values.push_back(coupling);
+        diagonal -= coupling;
+      }
+      matrix.columns.push_back(index(I));
+      matrix.values.push_back(diagonal);
+      matrix.row_begin.push_back(matrix.columns.size());
+    }
+  }
+}
+
+CSRMatrix SparseMatrixOperator::local_block() const
+{
+  CSRMatrix block;
+  block.rows = matrix.rows;
+  block.cols = matrix.rows;
+  block.row_begin.reserve(matrix.rows + 1);
+  for (int i = 0; i < matrix.rows; i++)
+  {
+    for (int k = matrix.row_begin[i]; k < matrix.row_begin[i + 1]; k++)
+    {
+      Index I = { static_cast<uint16_t>(matrix.columns[k] % size_x), static_cast<uint16_t>(matrix.columns[k] / size_x) };
+      if (I.x < range.begin.x || I.x > range.end.x || I.y < range.begin.y || I.y > range.end.y)
+        continue;
+      block.columns.push_back(row(I));
+      block.values.push_back(matrix.values[k]);
+    }
+    block.row_begin.push_back(block.columns.size());
+  }
+  return block;
+}
@@ -5,8 +5,54 @@
 #include "pde/system.h"
 #include "utils/broadcast.h"
 #include "utils/index.h"
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <utility>
+#include <vector>
+
+// compressed sparse rows, the columns of a row are not sorted
+struct CSRMatrix
+{
+  int rows = 0;
+  int cols = 0;
+  std::vector<int> row_begin = { 0 };
+  std::vector<int> columns;
+  std::vector<double> values;
+};
+
+CSRMatrix transpose(const CSRMatrix& A);
+// A * B, accumulated row by row
+CSRMatrix multiply(const CSRMatrix& A, const CSRMatrix& B);
+// y = A * x
+void multiply(const CSRMatrix& A, const double* x, double* y);
+
+// assembled pressure operator with one CSR row per cell of the range in lexicographic order.
+// The columns are storage indices of the grid, so the halo cells of the neighbouring ranks are
+// read in place, while the Neumann ghosts are folded into the diagonal. Unlike the
+// LaplaceMatrixOperator every row carries its own coefficients
 struct SparseMatrixOperator
 {
+  Range range;
+  int size_x; // of the grid storage
+  int row_length;
+  CSRMatrix matrix;
+  // 5-point laplacian of the pressure grid `layout`
+  SparseMatrixOperator(const Grid2D& layout, const Gridsize& h, const Partitioning::MPIInfo& partitioning);
+
+  inline int row(Index I) const { return (I.x - range.begin.x) + row_length * (I.y - range.begin.y); }
+
+  inline double operator()(const Grid2D& vec, Index I) const
+  {
+    int r = row(I);
+    double res = 0.;
+    for (int k = matrix.row_begin[r]; k < matrix.row_begin[r + 1]; k++)
+      res += matrix.values[k] * vec[static_cast<uint32_t>(matrix.columns[k])];
+    return res;
+  }
+
+  // square matrix of the rank local cells, the couplings to the halo are dropped
+  CSRMatrix local_block() const;
 };
 
 struct LaplaceMatrixOperator
@@ -33,6 +79,26 @@ struct LaplaceMatrixOperator
     res += a_ij * vec[I];
     return res;
   }
+
+  // A x at cell k of a row, given the rows south, centre and north of it
+  inline double operator()(const double* south, const double* centre, const double* north, int k) const
+  {
+    double res = ((centre[k - 1] + centre[k + 1]) * h_x_squared_inv) + ((south[k] + north[k]) * h_y_squared_inv);
+    res += a_ij * centre[k];
+    return res;
+  }
+
+  // extreme nonzero eigenvalues for nx x ny cells with neumann boundaries, {most negative, closest to zero}
+  inline std::pair<double, double> spectrum(int nx, int ny) const
+  {
+    auto mode = [](double h_squared_inv, int k, int n) {
+      double s = std::sin(std::numbers::pi * k / (2. * n));
+      return -4. * h_squared_inv * s * s;
+    };
+    double lower = mode(h_x_squared_inv, nx - 1, nx) + mode(h_y_squared_inv, ny - 1, ny);
+    double upper = std::max(nx > 1 ? mode(h_x_squared_inv, 1, nx) : -INFINITY, ny > 1 ? mode(h_y_squared_inv, 1, ny) : -INFINITY);
+    return { lower, upper };
+  }
 };
 
 #endif // MATRIX_H_
@@ -6,17 +6,26 @@
 #include "utils/partitioning.h"
 #include "utils/profiler.h"
 #include "utils/settings.h"
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <grid/grid.h>
 #include <mpi.h>
 #include <utility>
 
+// sum and maximum of a fused pass, reduced together in a single allreduce
+struct Reduction
+{
+  double sum = 0.;
+  double max = 0.;
+};
+
 template <typename Operator, typename... Args>
 inline double sum(Operator&& O, Range r, Args&&... args)
 {
   double result = 0;
   ProfileScope("Reduction");
-  // #pragma omp parallel for simd collapse(2) reduction(+ : result)
+#pragma omp parallel for schedule(static) reduction(+ : result) if (r.count() >= PARALLEL_CELLS)
   for (uint16_t j = r.begin.y; j <= r.end.y; j++)
   {
     for (uint16_t i = r.begin.x; i <= r.end.x; i++)
@@ -27,6 +36,41 @@ inline double sum(Operator&& O, Range r, Args&&... args)
   return result;
 }
 
+template <typename Operator, typename... Args>
+inline double maximum(Operator&& O, Range r, Args&&... args)
+{
+  double result = 0;
+  ProfileScope("Max Reduction");
+#pragma omp parallel for schedule(static) reduction(max : result) if (r.count() >= PARALLEL_CELLS)
+  for (uint16_t j = r.begin.y; j <= r.end.y; j++)
+  {
+    for (uint16_t i = r.begin.x; i <= r.end.x; i++)
+    {
+      result = std::max(result, std::forward<Operator>(O)(Index { i, j }, std::forward<Args>(args)...));
+    }
+  }
+  return result;
+}
+
+// runs the row kernel K(I, n, args...) on every row of the range like broadcast_rows and reduces the
+// sums and maxima it returns
+template <typename Kernel, typename... Args>
+inline Reduction reduce_rows(Kernel&& K, Range r, Args&&... args)
+{
+  ProfileScope("Row Reduction");
+  const int n = r.end.x - r.begin.x + 1;
+  double sum = 0.;
+  double max = 0.;
+#pragma omp parallel for schedule(static) reduction(+ : sum) reduction(max : max) if (r.count() >= PARALLEL_CELLS)
+  for (int j = r.begin.y; j <= r.end.y; j++)
+  {
+    Reduction row = K(Index { r.begin.x, static_cast<uint16_t>(j) }, n, args...);
+    sum += row.sum;
+    max = std::max(max, row.max);
+  }
+  return { sum, max };
+}
+
 inline Range plusBoundary(Range r)
 {
   auto info = Settings::get().mpi;
@@ -48,10 +92,65 @@ inline double distributed_sum(Operator&& O, Range r, Args&&... args)
 {
   double local_sum = sum(std::forward<Operator>(O), r, std::forward<Args>(args)...);
   double global_sum = 0.;
-  MPI_Allreduce(&local_sum, &global_sum, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+  MPI_Allreduce(&local_sum, &global_sum, 1, MPI_DOUBLE, MPI_SUM, Partitioning::getCommunicator());
   return global_sum;
 }
 
+template <typename Operator, typename... Args>
+inline double distributed_max(Operator&& O, Range r, Args&&... args)
+{
+  double local_max = maximum(std::forward<Operator>(O), r, std::forward<Args>(args)...);
+  double global_max = 0.;
+  MPI_Allreduce(&local_max, &global_max, 1, MPI_DOUBLE, MPI_MAX, Partitioning::getCommunicator());
+  return global_max;
+}
+
+
+inline void sum_max(void* in, void* inout, int* len, MPI_Datatype*)
+{
+  Reduction* a = static_cast<Reduction*>(in);
+  Reduction* b = static_cast<Reduction*>(inout);
+  for (int k = 0; k < *len; k++)
+  {
+    b[k].sum += a[k].sum;
+    b[k].max = std::max(a[k].max, b[k].max);
+  }
+}
+
+inline Reduction distributed_reduction(Reduction local)
+{
+  static MPI_Datatype type = [] {
+    MPI_Datatype t;
+    MPI_Type_contiguous(2, MPI_DOUBLE, &t);
+    MPI_Type_commit(&t);
+    return t;
+  }();
+  static MPI_Op op = [] {
+    MPI_Op o;
+    MPI_Op_create(sum_max, 1, &o);
+    return o;
+  }();
+  Reduction global;
+  MPI_Allreduce(&local, &global, 1, type, op, Partitioning::getCommunicator());
+  return global;
+}
+
+inline double absolute(Index I, const Grid2D& a)
+{
+  return std::abs(a[I]);
+}
+
+inline double value(Index I, const Grid2D& a)
+{
+  return a[I];
+}
+
+inline double norm_max(Grid2D& a)
+{
+  ProfileScope("Max Norm");
+  return distributed_max(absolute, a.range, a);
+}
+
 inline double times(Index I, const Grid2D& a, const Grid2D& b)
 {
   return a[I] * b[I];
@@ -81,9 +180,35 @@ inline void axpy(Index I, Grid2D& result, double a, const Grid2D& x, const Grid2
 {
   result[I] = a * x[I] + y[I];
 };
-inline void aAxpy(Index I, Grid2D& result, double a, LaplaceMatrixOperator A, const Grid2D& x, const Grid2D& y)
+inline void add_constant(Index I, Grid2D& result, double a)
+{
+  result[I] += a;
+};
+inline void axpby(Index I, Grid2D& result, double a, const Grid2D& x, double b, const Grid2D& y)
+{
+  result[I] = a * x[I] + b * y[I];
+};
+inline void Ax(Index I, Grid2D& result, LaplaceMatrixOperator A, const Grid2D& x)
 {
-  result[I] = a * A(x, I) + y[I];
+  result[I] = A(x, I);
+};
+inline void scale(Index I, Grid2D& result, double a, const Grid2D& x)
+{
+  result[I] = a * x[I];
+};
+// result = a * A x + y on the row of n cells starting at I
+inline void aAxpy_row(Index I, int n, Grid2D& result, double a, const LaplaceMatrixOperator& A, const Grid2D& x, const Grid2D& y)
+{
+  double* __restrict out = result.row(I);
+  const double* __restrict south = x.row(I - Iy);
+  const double* __restrict centre = x.row(I);
+  const double* __restrict north = x.row(I + Iy);
+  const double* __restrict b = y.row(I);
+#pragma omp simd
+  for (int k = 0; k < n; k++)
+  {
+    out[k] = a * A(south, centre, north, k) + b[k];
+  }
 };
 
 #endif // VECTOR_H_
@@ -10,6 +10,7 @@
 #include <iostream>
 #include <mpi.h>
 #include <output/vtk.h>
+#include <pde/parareal.h>
 #include <pde/system.h>
 #include <sstream>
 #include <utils/partitioning.h>
@@ -28,7 +29,9 @@ auto main(int argc, char* argv[]) -> int
   signal(SIGINT, signalInt);
   signal(SIGTERM, signalInt);
 
-  MPI_Init(&argc, &argv);
+  // only the main thread calls MPI, the OpenMP regions sit between the communication
+  int provided;
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
   int rank, size;
   MPI_Comm_rank(MPI_COMM_WORLD, &rank);
   MPI_Comm_size(MPI_COMM_WORLD, &size);
@@ -51,13 +54,26 @@ auto main(int argc, char* argv[]) -> int
     return -1;
   }
   // Settings::get().printSettings();
+  TimeSlice slice = split_time(rank, size);
   Partitioning::MPIInfo mpiInfo = Partitioning::MPIInfo();
-  setMPIInfo(mpiInfo, Settings::get(), rank, size);
+  setMPIInfo(mpiInfo, Settings::get(), slice.rank, slice.size);
   Settings::set().mpi = mpiInfo;
+  if (provided < MPI_THREAD_FUNNELED)
+    LOG::Warning("the MPI library does not support threads");
+  Partitioning::pinThreads(Settings::get().threads);
   PDESystem system = PDESystem(Settings::get(), mpiInfo);
 
   vtk_par::init(system);
 
+  if (slice.count > 1)
+  {
+    parareal(system, slice);
+    MPI_Finalize();
+    LOG::Close();
+    Profiler::Close();
+    return 0;
+  }
+
   std::cout << "Hello from Rank " << rank << " of " << size << std::endl;
   std::cout << "nX " << mpiInfo.nCells[0] << " nY " << mpiInfo.nCells[1] << std::endl;
 
@@ -184,11 +184,11 @@ void reduceAll(const PDESystem& system, const Partitioning::MPIInfo& mpi)
   // debugRanges(v, srcRV, dstRV);
   vGrid.copyFromTo(system.v, srcRV, dstRV);
 
-  MPI_Reduce(pressureGrid.data(), GlobalpressureGrid.data(), pressureGrid.size(), MPI_DOUBLE, MPI_SUM, root_rank, MPI_COMM_WORLD);
-  MPI_Reduce(uGrid.data(), GlobaluGrid.data(), uGrid.size(), MPI_DOUBLE, MPI_SUM, root_rank, MPI_COMM_WORLD);
-  MPI_Reduce(vGrid.data(), GlobalvGrid.data(), vGrid.size(), MPI_DOUBLE, MPI_SUM, root_rank, MPI_COMM_WORLD);
+  MPI_Reduce(pressureGrid.data(), GlobalpressureGrid.data(), pressureGrid.size(), MPI_DOUBLE, MPI_SUM, root_rank, Partitioning::getCommunicator());
+  MPI_Reduce(uGrid.data(), GlobaluGrid.data(), uGrid.size(), MPI_DOUBLE, MPI_SUM, root_rank, Partitioning::getCommunicator());
+  MPI_Reduce(vGrid.data(), GlobalvGrid.data(), vGrid.size(), MPI_DOUBLE, MPI_SUM, root_rank, Partitioning::getCommunicator());
 }
-void writeVTK(const PDESystem& system, double dt)
+void writeVTK(const PDESystem& system, double dt, int number)
 {
   Partitioning::MPIInfo mpi = system.settings.mpi;
   reduceAll(system, mpi);
@@ -197,6 +197,8 @@ void writeVTK(const PDESystem& system, double dt)
     return;
 
   static int fileNumber = 0;
+  if (number >= 0)
+    fileNumber = number;
   set_filename(vtkWriter_, fileNumber);
   auto dataSet = initialize_dataset(system);
 
@@ -17,43 +17,98 @@
     }                                                            \
   } while (0)
 
-inline double d(Offset Direction, const Grid2D& field, Index I, double h)
+enum class Axis
 {
-  assert(Direction.x <= I.x + 1);
-  assert(Direction.y <= I.y + 1);
-  return 1 / h * (field[I + Direction] - field[I]);
-}
-inline double dd(Offset Direction, const Grid2D& field, Index I, double h_squared)
-{
-  assert(Direction.x <= I.x);
-  assert(Direction.y <= I.y);
-  return 1 / h_squared * (field[I + Direction] + field[I - Direction] - 2 * field[I]);
-}
-inline double duv(Offset Direction, const Grid2D& field1, const Grid2D& field2, Index I, double h, double alpha)
+  X,
+  Y
+};
+
+// the values of a field around one row, given as pointers to the cells of the rows south, centre and north.
+// at<D, along, across>(k) is the value at cell k of the row shifted by `along` cells in direction D and by
+// `across` cells in the other direction, the shifts are resolved at compile time
+struct Rows
 {
-  assert(Direction.x <= I.x);
-  assert(Direction.y <= I.y);
-  if (Direction == Ix)
+  const double* south;
+  const double* centre;
+  const double* north;
+
+  Rows(const Grid2D& field, Index I)
+    : south(field.row(I - Iy))
+    , centre(field.row(I))
+    , north(field.row(I + Iy))
   {
-    double donor_cell_correction = alpha * (1 / h) * ((std::abs(field1[I + Iy] + field1[I]) * (field2[I] - field2[I + Ix])) / 4 - (std::abs(field1[I - Ix] + field1[I - Ix + Iy]) * (field2[I - Ix] - field2[I])) / 4);
-    return (1 / h) * (((field1[I + Iy] + field1[I]) * (field2[I + Ix] + field2[I])) / 4 - ((field1[I - Ix] + field1[I - Ix + Iy]) * (field2[I] + field2[I - Ix])) / 4) + donor_cell_correction;
-  } else if (Direction == Iy)
+  }
+
+  template <Axis D, int along, int across = 0>
+  inline double at(int k) const
   {
-    double donor_cell_correction = alpha * (1 / h) * ((std::abs(field2[I + Ix] + field2[I]) * (field1[I] - field1[I + Iy])) / 4 - (std::abs(field2[I - Iy] + field2[I - Iy + Ix]) * (field1[I - Iy] - field1[I])) / 4);
-    return (1 / h) * (((field1[I + Iy] + field1[I]) * (field2[I + Ix] + field2[I])) / 4 - ((field1[I] + field1[I - Iy]) * (field2[I - Iy] + field2[I - Iy + Ix])) / 4) + donor_cell_correction;
-  } else
+    constexpr int x = (D == Axis::X) ? along : across;
+    constexpr int y = (D == Axis::X) ? across : along;
+    static_assert(y >= -1 && y <= 1, "a row stencil reaches one row to the south and the north");
+    if constexpr (y < 0)
+      return south[k + x];
+    else if constexpr (y > 0)
+      return north[k + x];
+    else
+      return centre[k + x];
+  }
+};
+
+// reciprocal spacings, the kernels multiply instead of dividing per cell
+struct InverseGridsize
+{
+  const double x;
+  const double y;
+  const double x_squared;
+  const double y_squared;
+
+  InverseGridsize(const Gridsize& h)
+    : x(1 / h.x)
+    , y(1 / h.y)
+    , x_squared(1 / h.x_squared)
+    , y_squared(1 / h.y_squared)
   {
-    assert(false && "Invalid Direction for duv");
-    return 0.0;
   }
+
+  template <Axis D>
+  inline double along() const { return (D == Axis::X) ? x : y; }
+  template <Axis D>
+  inline double along_squared() const { return (D == Axis::X) ? x_squared : y_squared; }
+};
+
+// forward difference f[+D] - f
+template <Axis D>
+inline double d(const Rows& f, int k, const InverseGridsize& h)
+{
+  return h.along<D>() * (f.at<D, 1>(k) - f.at<D, 0>(k));
+}
+
+template <Axis D>
+inline double dd(const Rows& f, int k, const InverseGridsize& h)
+{
+  return h.along_squared<D>() * (f.at<D, 1>(k) + f.at<D, -1>(k) - 2 * f.at<D, 0>(k));
+}
+
+// d(f^2)/dD of the velocity along D, with the donor cell correction weighted by alpha
+template <Axis D>
+inline double dxx(const Rows& f, int k, const InverseGridsize& h, double alpha)
+{
+  const double minus = f.at<D, -1>(k);
+  const double centre = f.at<D, 0>(k);
+  const double plus = f.at<D, 1>(k);
+  double donor_cell_correction = alpha * h.along<D>() * ((std::abs(plus + centre) * (centre - plus)) / 4 - (std::abs(minus + centre) * (minus - centre)) / 4);
+  return h.along<D>() * (((plus + centre) * (plus + centre)) / 4 - ((minus + centre) * (centre + minus)) / 4) + donor_cell_correction;
 }
 
-inline double dxx(Offset Direction, const Grid2D& field1, const Grid2D& field2, Index I, double h, double alpha)
+// d(ab)/dD of the velocity a across D, transported by the velocity b along D, which is interpolated
+// onto the corners of the cell of a
+template <Axis D>
+inline double duv(const Rows& a, const Rows& b, int k, const InverseGridsize& h, double alpha)
 {
-  assert(Direction.x <= I.x);
-  assert(Direction.y <= I.y);
-  double donor_cell_correction = alpha * (1 / h) * ((std::abs(field1[I + Direction] + field1[I]) * (field2[I] - field2[I + Direction])) / 4 - (std::abs(field1[I - Direction] + field1[I]) * (field2[I - Direction] - field2[I])) / 4);
-  return (1 / h) * (((field1[I + Direction] + field1[I]) * (field2[I + Direction] + field2[I])) / 4 - ((field1[I - Direction] + field1[I]) * (field2[I] + field2[I - Direction])) / 4) + donor_cell_correction;
+  const double b_plus = b.at<D, 0, 1>(k) + b.at<D, 0>(k);
+  const double b_minus = b.at<D, -1>(k) + b.at<D, -1, 1>(k);
+  double donor_cell_correction = alpha * h.along<D>() * ((std::abs(b_plus) * (a.at<D, 0>(k) - a.at<D, 1>(k))) / 4 - (std::abs(b_minus) * (a.at<D, -1>(k) - a.at<D, 0>(k))) / 4);
+  return h.along<D>() * (((a.at<D, 1>(k) + a.at<D, 0>(k)) * b_plus) / 4 - ((a.at<D, 0>(k) + a.at<D, -1>(k)) * b_minus) / 4) + donor_cell_correction;
 }
 
 #endif // DERIVATIVES_H_
@@ -0,0 +1,104 @@
+#include "pde/initialguess.h"
+#include "linalg/matrix.h"
+#include "linalg/vector.h"
+#include "pde/pressuresolvers.h"
+#include "utils/broadcast.h"
+#include "utils/profiler.h"
+#include "utils/settings.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <mpi.h>
+
+static size_t history_length()
+{
+  switch (Settings::get().initialGuess)
+  {
+  case Settings::InitialGuess::Linear:
+    return 2;
+  case Settings::InitialGuess::Quadratic:
+    return 3;
+  default:
+    return 1;
+  }
+}
+
+PressureHistory::PressureHistory(PDESystem& system)
+  : times(history_length())
+  , guess(system.p.begin, system.p.end)
+{
+  fields.reserve(times.size());
+  for (size_t i = 0; i < times.size(); i++)
+    fields.emplace_back(system.p.begin, system.p.end);
+}
+
+inline void add_scaled(Index I, Offset O, Grid2D& result, double a, const Grid2D& x)
+{
+  result[I] += a * x[I];
+}
+
+inline void subtract_A(Index I, Grid2D& rhs, LaplaceMatrixOperator A, const Grid2D& x)
+{
+  rhs[I] -= A(x, I);
+}
+
+inline double residual_magnitude(Index I, LaplaceMatrixOperator A, const Grid2D& p, const Grid2D& rhs)
+{
+  return std::abs(rhs[I] - A(p, I));
+}
+
+void initial_guess(PressureHistory& history, PDESystem& system, double time)
+{
+  ProfileScope("Pressure Initial Guess");
+  LaplaceMatrixOperator A = LaplaceMatrixOperator(system.h);
+  // ghosts are extrapolated as well, they are linear in the interior values
+  Range all = { system.p.begin - II, system.p.end + II };
+  if (history.count > 1)
+  {
+    // lagrange extrapolation through the stored times
+    parallel_broadcast(set, all, Offset { 0, 0 }, history.guess, 0.);
+    size_t n = history.fields.size();
+    for (size_t i = history.head; i < history.head + history.count; i++)
+    {
+      double weight = 1.;
+      for (size_t j = history.head; j < history.head + history.count; j++)
+      {
+        if (j != i)
+          weight *= (time - history.times[j % n]) / (history.times[i % n] - history.times[j % n]);
+      }
+      parallel_broadcast(add_scaled, all, Offset { 0, 0 }, history.guess, weight, history.fields[i % n]);
+    }
+    // the extrapolation amplifies the iteration error of the stored fields, with a loose tolerance
+    // the previous pressure can be the better start
+    broadcast_boundary(copy_with_offset, system.partitioning, system.p.boundary, system.p);
+    std::array<double, 2> residuals = { maximum(residual_magnitude, system.p.range, A, system.p, system.rhs), maximum(residual_magnitude, system.p.range, A, history.guess, system.rhs) };
+    MPI_Allreduce(MPI_IN_PLACE, residuals.data(), 2, MPI_DOUBLE, MPI_MAX, Partitioning::getCommunicator());
+    if (residuals[1] < residuals[0])
+    {
+      ProfileScope("Extrapolated Guess");
+      parallel_broadcast(copy, all, Offset { 0, 0 }, history.guess, system.p);
+    }
+  }
+  if (!Settings::get().pressureIncrement)
+    return;
+
+  // solve A dp = rhs - A guess starting from dp = 0
+  parallel_broadcast(copy, all, Offset { 0, 0 }, system.p, history.guess);
+  broadcast_boundary(copy_with_offset, system.partitioning, history.guess.boundary, history.guess);
+  parallel_broadcast(subtract_A, system.p.range, system.rhs, A, history.guess);
+  parallel_broadcast(set, all, Offset { 0, 0 }, system.p, 0.);
+}
+
+void record_pressure(PressureHistory& history, PDESystem& system, double time)
+{
+  ProfileScope("Pressure Initial Guess");
+  Range all = { system.p.begin - II, system.p.end + II };
+  if (Settings::get().pressureIncrement)
+    parallel_broadcast(add_scaled, all, Offset { 0, 0 }, system.p, 1., history.guess);
+
+  // the oldest field is overwritten
+  history.head = (history.head + history.fields.size() - 1) % history.fields.size();
+  history.count = std::min(history.count + 1, history.fields.size());
+  history.times[history.head] = time;
+  parallel_broadcast(copy, all, Offset { 0, 0 }, system.p, history.fields[history.head]);
+}
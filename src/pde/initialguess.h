@@ -0,0 +1,27 @@
+#ifndef INITIALGUESS_H_
+#define INITIALGUESS_H_
+
+#include <cstddef>
+#include <grid/grid.h>
+#include <pde/system.h>
+#include <vector>
+
+// ring buffer of the last solved pressure fields, extrapolated in time to the next solve
+struct PressureHistory
+{
+  std::vector<Grid2D> fields;
+  std::vector<double> times;
+  size_t count = 0;
+  size_t head = 0;
+  // extrapolated guess, kept for the increment formulation
+  Grid2D guess;
+  PressureHistory(PDESystem& system);
+};
+
+// writes the initial guess for the pressure solve at the given time into system.p,
+// for the increment formulation system.rhs and system.p are turned into the increment problem
+void initial_guess(PressureHistory& history, PDESystem& system, double time);
+// restores the pressure of the increment formulation and stores the solution
+void record_pressure(PressureHistory& history, PDESystem& system, double time);
+
+#endif // INITIALGUESS_H_
@@ -0,0 +1,305 @@
+#include "pde/parareal.h"
+#include "output/vtk_par.h"
+#include "pde/initialguess.h"
+#include "pde/pressuresolvers.h"
+#include "utils/Logger.h"
+#include "utils/distributed.h"
+#include "utils/partitioning.h"
+#include "utils/profiler.h"
+#include "utils/settings.h"
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <grid/grid.h>
+#include <mpi.h>
+#include <utility>
+#include <vector>
+
+TimeSlice split_time(int rank, int size)
+{
+  const int count = Settings::get().timeSlices;
+  const double end_time = Settings::get().endTime;
+  if (count <= 1)
+    return { 0, 1, rank, size, 0., end_time };
+  if (size % count != 0)
+  {
+    ErrorF("{} ranks can not be split into {} time slices", size, count);
+    abort();
+  }
+  TimeSlice slice;
+  slice.index = rank / (size / count);
+  slice.count = count;
+  MPI_Comm comm;
+  MPI_Comm_split(MPI_COMM_WORLD, slice.index, rank, &comm);
+  Partitioning::setCommunicator(comm);
+  MPI_Comm_rank(comm, &slice.rank);
+  MPI_Comm_size(comm, &slice.size);
+  slice.begin = end_time * slice.index / count;
+  slice.end = end_time * (slice.index + 1) / count;
+  return slice;
+}
+
+static void save(const Grid2D& grid, std::vector<double>& values)
+{
+  values.resize(grid.elements());
+  for (uint32_t k = 0; k < grid.elements(); k++)
+    values[k] = grid[k];
+}
+
+static void load(const std::vector<double>& values, Grid2D& grid)
+{
+  for (uint32_t k = 0; k < grid.elements(); k++)
+    grid[k] = values[k];
+}
+
+static void save(const PDESystem& system, FlowState& state)
+{
+  save(system.u, state.u);
+  save(system.v, state.v);
+  save(system.p, state.p);
+}
+
+static void load(const FlowState& state, PDESystem& system)
+{
+  load(state.u, system.u);
+  load(state.v, system.v);
+  load(state.p, system.p);
+  // the slice restarts at its beginning, older pressures are from the end of the slice
+  system.history->count = 0;
+}
+
+// state += a * other
+static void add_scaled(FlowState& state, double a, const FlowState& other)
+{
+  for (auto [x, y] : { std::pair { &state.u, &other.u }, { &state.v, &other.v }, { &state.p, &other.p } })
+  {
+    for (size_t k = 0; k < x->size(); k++)
+      (*x)[k] += a * (*y)[k];
+  }
+}
+
+// corresponding ranks of consecutive slices own the same cells, the states are sent as they are stored
+static void send(const FlowState& state, int to, std::array<MPI_Request, 3>& requests)
+{
+  MPI_Isend(state.u.data(), state.u.size(), MPI_DOUBLE, to, 0, MPI_COMM_WORLD, &requests[0]);
+  MPI_Isend(state.v.data(), state.v.size(), MPI_DOUBLE, to, 1, MPI_COMM_WORLD, &requests[1]);
+  MPI_Isend(state.p.data(), state.p.size(), MPI_DOUBLE, to, 2, MPI_COMM_WORLD, &requests[2]);
+}
+
+static void receive(FlowState& state, int from)
+{
+  ProfileScope("Parareal Receive");
+  MPI_Recv(state.u.data(), state.u.size(), MPI_DOUBLE, from, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+  MPI_Recv(state.v.data(), state.v.size(), MPI_DOUBLE, from, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+  MPI_Recv(state.p.data(), state.p.size(), MPI_DOUBLE, from, 2, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+}
+
+static void exchange_halos(PDESystem& system)
+{
+  broadcast_boundary(copy_with_offset, system.partitioning, system.p.boundary, system.p);
+  MPI_COMM_BUFFER* p_comm_buffer = new MPI_COMM_BUFFER(system.p, system.p.boundary.all, Partitioning::getCommunicator(), system.partitioning);
+  MPI_COMM_BUFFER* u_comm_buffer = new MPI_COMM_BUFFER(system.u, system.u.boundary.u_ghosts(), Partitioning::getCommunicator(), system.partitioning, 16);
+  MPI_COMM_BUFFER* v_comm_buffer = new MPI_COMM_BUFFER(system.v, system.v.boundary.v_ghosts(), Partitioning::getCommunicator(), system.partitioning, 32);
+  delete p_comm_buffer;
+  delete u_comm_buffer;
+  delete v_comm_buffer;
+}
+
+// storage index of the local cell (x, y), the right face for u and the top face for v
+static Index cell(const PDESystem& system, int x, int y)
+{
+  return { static_cast<uint16_t>(system.begin.x + x), static_cast<uint16_t>(system.begin.y + y) };
+}
+
+// averages of the fine cells and of the fine faces on the coarse faces
+static void restrict_state(const PDESystem& fine, PDESystem& coarse)
+{
+  auto x = [&](Index I) { return I.x - coarse.begin.x; };
+  auto y = [&](Index I) { return I.y - coarse.begin.y; };
+  for (uint16_t j = coarse.p.range.begin.y; j <= coarse.p.range.end.y; j++)
+  {
+    for (uint16_t i = coarse.p.range.begin.x; i <= coarse.p.range.end.x; i++)
+    {
+      Index I = { i, j };
+      Index F = cell(fine, 2 * x(I), 2 * y(I));
+      coarse.p[I] = (fine.p[F] + fine.p[F + Ix] + fine.p[F + Iy] + fine.p[F + Ix + Iy]) / 4.;
+    }
+  }
+  for (uint16_t j = coarse.u.range.begin.y; j <= coarse.u.range.end.y; j++)
+  {
+    for (uint16_t i = coarse.u.range.begin.x; i <= coarse.u.range.end.x; i++)
+    {
+      Index I = { i, j };
+      Index F = cell(fine, 2 * x(I) + 1, 2 * y(I));
+      coarse.u[I] = (fine.u[F] + fine.u[F + Iy]) / 2.;
+    }
+  }
+  for (uint16_t j = coarse.v.range.begin.y; j <= coarse.v.range.end.y; j++)
+  {
+    for (uint16_t i = coarse.v.range.begin.x; i <= coarse.v.range.end.x; i++)
+    {
+      Index I = { i, j };
+      Index F = cell(fine, 2 * x(I), 2 * y(I) + 1);
+      coarse.v[I] = (fine.v[F] + fine.v[F + Ix] + 0.) / 2.;
+    }
+  }
+}
+
+// linear interpolation of a staggered coarse velocity on the fine face (a, c), a counts the faces
+// along the velocity and c the cells across. Odd faces lie on a coarse face, even ones halfway between two,
+// across the fine cell centres are a quarter cell away from the nearest coarse one. Next to a wall the
+// ghost value would carry the wall velocity into the boundary layer, there the nearest value is kept
+static double prolongate_face(const PDESystem& coarse, const Grid2D& velocity, Offset along, int a, int c)
+{
+  auto value = [&](int A, int C) {
+    Index I = cell(coarse, 0, 0) + Offset { along.x * A + along.y * C, along.y * A + along.x * C };
+    return velocity[I];
+  };
+  const Partitioning::MPIInfo& info = coarse.partitioning;
+  int cells = (along == Ix) ? info.nCells[1] : info.nCells[0];
+  bool lower_wall = ((along == Ix) ? info.bottom_neighbor : info.left_neighbor) < 0;
+  bool upper_wall = ((along == Ix) ? info.top_neighbor : info.right_neighbor) < 0;
+  int C = c / 2;
+  int neighbour = (c % 2 == 0) ? C - 1 : C + 1;
+  if ((neighbour < 0 && lower_wall) || (neighbour >= cells && upper_wall))
+    neighbour = C;
+  auto across = [&](int A) { return 0.75 * value(A, C) + 0.25 * value(A, neighbour); };
+  if (a % 2 != 0)
+    return across((a - 1) / 2);
+  return (across(a / 2 - 1) + across(a / 2)) / 2.;
+}
+
+static void prolongate_state(const PDESystem& coarse, PDESystem& fine)
+{
+  auto x = [&](Index I) { return I.x - fine.begin.x; };
+  auto y = [&](Index I) { return I.y - fine.begin.y; };
+  for (uint16_t j = fine.p.range.begin.y; j <= fine.p.range.end.y; j++)
+  {
+    for (uint16_t i = fine.p.range.begin.x; i <= fine.p.range.end.x; i++)
+    {
+      Index I = { i, j };
+      fine.p[I] = coarse.p[cell(coarse, x(I) / 2, y(I) / 2)];
+    }
+  }
+  for (uint16_t j = fine.u.range.begin.y; j <= fine.u.range.end.y; j++)
+  {
+    for (uint16_t i = fine.u.range.begin.x; i <= fine.u.range.end.x; i++)
+    {
+      Index I = { i, j };
+      fine.u[I] = prolongate_face(coarse, coarse.u, Ix, x(I), y(I));
+    }
+  }
+  for (uint16_t j = fine.v.range.begin.y; j <= fine.v.range.end.y; j++)
+  {
+    for (uint16_t i = fine.v.range.begin.x; i <= fine.v.range.end.x; i++)
+    {
+      Index I = { i, j };
+      fine.v[I] = prolongate_face(coarse, coarse.v, Iy, y(I), x(I));
+    }
+  }
+}
+
+static void propagate(PDESystem& system, double begin, double end)
+{
+  double time = begin;
+  while (time < end)
+  {
+    step(system, time, end);
+    // the last step is shortened to end exactly at the end of the slice
+    time = (system.dt < end - time) ? time + system.dt : end;
+  }
+}
+
+static void fine_propagate(PDESystem& fine, const TimeSlice& slice, const FlowState& start, FlowState& result)
+{
+  ProfileScope("Parareal Fine");
+  load(start, fine);
+  propagate(fine, slice.begin, slice.end);
+  save(fine, result);
+}
+
+// the fine system is the workspace of the transfers
+static void coarse_propagate(PDESystem& fine, PDESystem& coarse, const TimeSlice& slice, const FlowState& start, FlowState& result)
+{
+  ProfileScope("Parareal Coarse");
+  load(start, fine);
+  restrict_state(fine, coarse);
+  exchange_halos(coarse);
+  coarse.history->count = 0;
+  propagate(coarse, slice.begin, slice.end);
+  prolongate_state(coarse, fine);
+  exchange_halos(fine);
+  save(fine, result);
+}
+
+void parareal(PDESystem& fine, const TimeSlice& slice)
+{
+  ProfileScope("Parareal");
+  Settings coarse_settings = Settings::get();
+  coarse_settings.nCells[0] /= 2;
+  coarse_settings.nCells[1] /= 2;
+  coarse_settings.tau = Settings::get().pararealCoarseTau;
+  Partitioning::MPIInfo coarse_info {};
+  Partitioning::setMPIInfo(coarse_info, coarse_settings, slice.rank, slice.size);
+  if (2 * coarse_info.nCells[0] != fine.partitioning.nCells[0] || 2 * coarse_info.nCells[1] != fine.partitioning.nCells[1])
+  {
+    ErrorF("the coarse propagator needs an even number of cells on every rank, got {}x{}", fine.partitioning.nCells[0], fine.partitioning.nCells[1]);
+    abort();
+  }
+  PDESystem coarse(coarse_settings, coarse_info);
+
+  int world_rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
+  const int previous = (slice.index > 0) ? world_rank - slice.size : -1;
+  const int next = (slice.index + 1 < slice.count) ? world_rank + slice.size : -1;
+  std::array<MPI_Request, 3> requests = { MPI_REQUEST_NULL, MPI_REQUEST_NULL, MPI_REQUEST_NULL };
+
+  // U_n^0 from the sequential coarse sweep, the first slice starts from the initial condition
+  FlowState start;
+  FlowState fine_end;
+  FlowState coarse_end;
+  FlowState previous_coarse_end;
+  FlowState corrected;
+  save(fine, start);
+  if (previous >= 0)
+    receive(start, previous);
+  coarse_propagate(fine, coarse, slice, start, previous_coarse_end);
+  corrected = previous_coarse_end;
+  if (next >= 0)
+    send(corrected, next, requests);
+
+  for (int k = 0; k < Settings::get().pararealIterations; k++)
+  {
+    // the fine propagation of all slices runs in parallel
+    fine_propagate(fine, slice, start, fine_end);
+    if (previous >= 0)
+      receive(start, previous);
+    coarse_propagate(fine, coarse, slice, start, coarse_end);
+    MPI_Waitall(3, requests.data(), MPI_STATUSES_IGNORE);
+    corrected = coarse_end;
+    add_scaled(corrected, 1., fine_end);
+    add_scaled(corrected, -1., previous_coarse_end);
+    if (next >= 0)
+      send(corrected, next, requests);
+    std::swap(previous_coarse_end, coarse_end);
+  }
+  MPI_Waitall(3, requests.data(), MPI_STATUSES_IGNORE);
+
+  // the output is written on the fine trajectory from the corrected start of the slice
+  ProfileScope("Parareal Output");
+  load(start, fine);
+  double time = slice.begin;
+  int next_written_time = std::floor(slice.begin) + 1;
+  while (time < slice.end)
+  {
+    step(fine, time, slice.end);
+    time = (fine.dt < slice.end - time) ? time + fine.dt : slice.end;
+    // the slices end exactly on their boundaries, a file due there is written by the slice before
+    if (time >= next_written_time)
+    {
+      vtk_par::writeVTK(fine, time, next_written_time - 1);
+      next_written_time++;
+    }
+  }
+}
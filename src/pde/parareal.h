@@ -0,0 +1,37 @@
+#ifndef PARAREAL_H_
+#define PARAREAL_H_
+
+#include <mpi.h>
+#include <pde/system.h>
+#include <vector>
+
+// part [begin, end) of the simulated time owned by a group of ranks. The ranks of a slice
+// share one spatial decomposition on their own communicator, rank r of every slice owns the same cells
+struct TimeSlice
+{
+  int index;
+  int count;
+  int rank; // in the spatial communicator
+  int size;
+  double begin;
+  double end;
+};
+
+// splits MPI_COMM_WORLD into Settings::timeSlices groups and makes the group the spatial communicator
+TimeSlice split_time(int rank, int size);
+
+// u, v and p including the halos, in the storage order of the grids
+struct FlowState
+{
+  std::vector<double> u;
+  std::vector<double> v;
+  std::vector<double> p;
+};
+
+// parareal over the time slices, U_{n+1}^{k+1} = G(U_n^{k+1}) + F(U_n^k) - G(U_n^k). The fine propagator F
+// are the time steps of `fine`, the coarse propagator G steps on a grid with half the cells and runs
+// sequentially through the slices. After the corrections every slice steps once more from its start
+// and writes the output of its interval
+void parareal(PDESystem& fine, const TimeSlice& slice);
+
+#endif // PARAREAL_H_
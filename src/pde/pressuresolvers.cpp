@@ -11,11 +11,20 @@
 #include <cmath>
 #include <cstdint>
 #include <cstdlib>
+#include <filesystem>
+#include <fstream>
 #include <grid/grid.h>
 #include <grid/indexing.h>
 #include <ios>
 #include <mpi.h>
+#include <numbers>
+#include <numeric>
+#include <sstream>
 #include <pde/system.h>
+#include <type_traits>
+#include <unistd.h>
+#include <variant>
+#include <vector>
 
 void solve(CGSolver& cg, PDESystem& system)
 {
@@ -23,18 +32,25 @@ void solve(CGSolver& cg, PDESystem& system)
   double old_residual_norm = INFINITY;
 
   LaplaceMatrixOperator A = LaplaceMatrixOperator(system.h);
+  auto apply_preconditioner = [&]() {
+    ProfileScope("Preconditioner");
+    std::visit([&](auto& M) { precondition(M, system, cg.residual, cg.preconditioned); }, cg.preconditioner);
+  };
+  // jacobi preconditioning is fused into the update pass
+  bool jacobi = std::holds_alternative<JacobiPreconditioner>(cg.preconditioner);
 
   // cg.residual = system.rhs - A*system.p;
   broadcast_boundary(copy_with_offset, system.partitioning, system.p.boundary, system.p);
   //  cg.residual[I] = s.rhs[I] - A(s.p, I);
-  parallel_broadcast(aAxpy, system.p.range, cg.residual, -1., A, system.p, system.rhs);
-  // A.a_ij modification for diagonal jacoby preconditioner
-  parallel_broadcast(axpy, system.p.range, cg.residual, (1 / A.a_ij - 1.), cg.residual, cg.residual);
-  residual_norm = dot(cg.residual, cg.residual);
+  broadcast_rows(aAxpy_row, system.p.range, cg.residual, -1., A, system.p, system.rhs);
+  apply_preconditioner();
+  residual_norm = dot(cg.residual, cg.preconditioned);
+  if (cg.coarse)
+    residual_norm += coarse_correction(*cg.coarse, system, cg.residual, cg.preconditioned);
 
   // ensure correct ghosts
-  // cg.search_direction = cg.residual;
-  distributed_broadcast(copy, system.partitioning, system.p.range, cg.search_direction, Offset { 0, 0 }, cg.residual, cg.search_direction);
+  // cg.search_direction = cg.preconditioned;
+  distributed_broadcast(copy, system.partitioning, system.p.range, cg.search_direction, Offset { 0, 0 }, cg.preconditioned, cg.search_direction);
 
   for (int iter = 0; iter < Settings::get().maximumNumberOfIterations; iter++)
   {
@@ -43,24 +59,38 @@ void solve(CGSolver& cg, PDESystem& system)
 
     broadcast_boundary(copy_with_offset, system.partitioning, cg.search_direction.boundary, cg.search_direction);
 
-    double alpha = residual_norm / Adot(A, cg.search_direction, cg.search_direction);
-
-    // A.a_ij modification for pcg mit diagonal jacoby preconditioner
-    //  system.p = system.p + a * cg.search_direction;
-    parallel_broadcast(axpy, system.p.range, system.p, A.a_ij * alpha, cg.search_direction, system.p);
+    // A*s is stored once and reused by the update pass
+    double local_sAs = reduce_rows(cg_apply_row, system.p.range, cg, A).sum;
+    double sAs = 0.;
+    MPI_Allreduce(&local_sAs, &sAs, 1, MPI_DOUBLE, MPI_SUM, Partitioning::getCommunicator());
+    double alpha = residual_norm / sAs;
 
+    // system.p = system.p + a * cg.search_direction;
     // cg.residual = cg.residual - a * A * cg.search_direction;
-    parallel_broadcast(aAxpy, system.p.range, cg.residual, -alpha, A, cg.search_direction, cg.residual);
-    ProfilePush("Residual Calculation");
-    double residual = cg.residual.max();
-    ProfilePop();
+    Reduction reduction;
+    if (jacobi)
+    {
+      reduction = reduce_rows(cg_update_jacobi_row, system.p.range, cg, system.p, alpha, 1. / A.a_ij);
+      ProfilePush("Residual Calculation");
+      reduction = distributed_reduction(reduction);
+      ProfilePop();
+    }
+    else
+    {
+      reduction = reduce_rows(cg_update_row, system.p.range, cg, system.p, alpha);
+      ProfilePush("Residual Calculation");
+      MPI_Allreduce(MPI_IN_PLACE, &reduction.max, 1, MPI_DOUBLE, MPI_MAX, Partitioning::getCommunicator());
+      ProfilePop();
+    }
+    // diagonally scaled like the former built in jacobi preconditioning, independent of the preconditioner
+    double residual = reduction.max / std::abs(A.a_ij);
     if (residual > 1e5 || residual == -NAN || residual == NAN)
     {
       ErrorF("residual exploded {}", residual);
 
       for (int i = 0; i < system.partitioning.size; i++)
       {
-        MPI_Barrier(MPI_COMM_WORLD);
+        MPI_Barrier(Partitioning::getCommunicator());
         if (system.partitioning.rank == i)
         {
           std::cout << "Hello from Rank " << system.partitioning.rank << " of " << system.partitioning.size << std::endl;
@@ -71,70 +101,144 @@ void solve(CGSolver& cg, PDESystem& system)
           std::cout << "RHS: " << system.rhs << std::endl;
         }
       }
-      MPI_Barrier(MPI_COMM_WORLD);
+      MPI_Barrier(Partitioning::getCommunicator());
       abort();
     }
 
     if (residual < Settings::get().epsilon)
     {
       // update Pressure ghosts
-      auto comm_buffer = new MPI_COMM_BUFFER(system.p, system.p.boundary.all, MPI_COMM_WORLD, system.partitioning);
+      auto comm_buffer = new MPI_COMM_BUFFER(system.p, system.p.boundary.all, Partitioning::getCommunicator(), system.partitioning);
       delete comm_buffer;
       // std::cout << "COnverged after N=" << iter << " Iterations" << std::endl;
       // DebugF("COnverged after {} Iterations", iter);
       break;
     }
-    residual_norm = dot(cg.residual, cg.residual);
+    if (jacobi)
+    {
+      residual_norm = reduction.sum;
+    }
+    else
+    {
+      apply_preconditioner();
+      residual_norm = dot(cg.residual, cg.preconditioned);
+    }
+    if (cg.coarse)
+      residual_norm += coarse_correction(*cg.coarse, system, cg.residual, cg.preconditioned);
     // DebugF("Residual Norm : {}", residual_norm);
     double beta = residual_norm / old_residual_norm;
     // DebugF("Beta: {}", beta);
 
-    // TODO Update Ghosts
-    // cg.search_direction[I] = cg.residual[I] + beta * cg.search_direction[I];
-    distributed_broadcast(axpy, system.partitioning, system.p.range, cg.search_direction, cg.search_direction, beta, cg.search_direction, cg.residual);
+    // cg.search_direction[I] = cg.preconditioned[I] + beta * cg.search_direction[I];
+    distributed_broadcast(axpy, system.partitioning, system.p.range, cg.search_direction, cg.search_direction, beta, cg.search_direction, cg.preconditioned);
   }
   broadcast_boundary(copy_with_offset, system.partitioning, system.p.boundary, system.p);
 }
 
 void solve(GaussSeidelSolver& S, PDESystem& system)
 {
-  system.residual = 0;
+  S.monitor.start();
   for (int iter = 0; iter < Settings::get().maximumNumberOfIterations; iter++)
   {
-    system.residual = 0;
     broadcast_boundary(copy_with_offset, system.partitioning, system.p.boundary, system.p);
-    broadcast(gauss_seidel_step, system.p.range, system, S);
-    if (system.residual < Settings::get().epsilon)
+    double local_residual = broadcast_wavefront(gauss_seidel_step, system.p.range, system);
+    MPI_COMM_BUFFER* comm_buffer = new MPI_COMM_BUFFER(system.p, system.p.boundary.all, Partitioning::getCommunicator(), system.partitioning);
+    delete comm_buffer;
+    if (S.monitor.converged(iter, local_residual))
     {
-      DebugF("Residual {:.14e} \nconverged after n={}", system.residual, iter);
+      DebugF("Residual {:.14e} \nconverged after n={}", S.monitor.residual, iter);
       break;
     }
   }
+  S.monitor.finish();
 }
 
-void solve(SORSolver& S, PDESystem& system)
+// global position of the first local cell on the given level. The offsets belong to the partition
+// of the system itself, which is coarser than the global Settings for the parareal coarse propagator.
+// Every level halves the cells of all ranks, so the offsets halve exactly as well
+static Index cell_offset(const Partitioning::MPIInfo& info, int level)
+{
+  return Index(info.cellOffset[0] >> level, info.cellOffset[1] >> level);
+}
+
+// colour of the first local cell on the given level, keeps black/red sweeps consistent across ranks
+static int blackred_parity(const Partitioning::MPIInfo& info, int level)
+{
+  Index offset = cell_offset(info, level);
+  return (offset.x + offset.y) % 2;
+}
+
+ChebyshevSolver::ChebyshevSolver(PDESystem& system)
+  : ChebyshevSolver(system.begin, system.end, LaplaceMatrixOperator(system.h).spectrum(system.settings.nCells[0], system.settings.nCells[1]))
+{
+}
+
+MultigridSmoother::MultigridSmoother(Index begin, Index end, const Gridsize& h, const Partitioning::MPIInfo& partitioning, int level, int nx, int ny)
+  : blackred(begin, end)
+  , chebyshev(begin, end, LaplaceMatrixOperator(h).spectrum(nx, ny))
+  , parity(blackred_parity(partitioning, level))
+{
+  // modes above half the frequency in either direction, [lambda_max, lambda_max / 4]
+  chebyshev.upper = chebyshev.lower / 4.;
+  if (Settings::get().multigridSmoother == Settings::Zebra)
+    zebra.emplace(begin, end, h, partitioning, level);
+}
+
+// red-black ordering is consistent, so the contraction lambda of SOR and the spectral radius mu
+// of the jacobi iteration satisfy (lambda + omega - 1)^2 = lambda omega^2 mu^2 (Young). lambda is
+// measured between the convergence checks and gives the optimum 2 / (1 + sqrt(1 - mu^2)).
+// Above the optimum the measured contraction overestimates omega - 1 and would drive omega
+// further up, so omega only grows and is frozen once the estimate settles. mu only depends on
+// the grid, the learned omega stays valid for all later time steps.
+static void adapt_omega(SORSolver& S, double lambda)
+{
+  if (S.learned || !(lambda > 0 && lambda < 1))
+    return;
+  double mu_squared = (lambda + S.omega - 1) * (lambda + S.omega - 1) / (lambda * S.omega * S.omega);
+  if (mu_squared < 1)
+  {
+    double omega = std::min(2. / (1. + std::sqrt(1. - mu_squared)), 1.99);
+    S.learned = omega - S.omega < 0.1 * (2. - S.omega);
+    S.omega = std::max(S.omega, omega);
+  }
+}
+
+// homogeneous neumann condition for the grids of either precision
+template <typename T>
+static void copy_ghost(Index I, Offset O, BasicGrid2D<T>& array)
+{
+  array[I] = array[I + O];
+}
+
+// red-black SOR sweeps until the monitor of S reports convergence, shared by the double and
+// the single precision pressure solve
+template <typename System>
+static void sor(SORSolver& S, System& system, int parity)
 {
-  Index gridpos = system.partitioning.getGridPos();
-  int parity = (gridpos.x + gridpos.y) % 2;
+  using T = typename std::remove_cvref_t<decltype(system.p)>::value_type;
+  S.monitor.start();
   for (int iter = 0; iter < Settings::get().maximumNumberOfIterations; iter++)
   {
     ProfileScope("SOR Iteration");
+    // while omega is learned the contraction is measured over short windows of constant omega
+    bool learning = Settings::get().adaptiveOmega && !S.learned;
+    S.monitor.min_interval = learning ? 10 : 1;
+    S.monitor.max_interval = learning ? 10 : 64;
     system.residual = 0;
-    broadcast_boundary(copy_with_offset, system.partitioning, system.p.boundary, system.p);
-    broadcast_blackred(sor_step, parity, system.p.range, system);
-    MPI_COMM_BUFFER* comm_black = new MPI_COMM_BUFFER(system.p, system.p.boundary.all, MPI_COMM_WORLD, system.partitioning);
+    broadcast_boundary(copy_ghost<T>, system.partitioning, system.p.boundary, system.p);
+    system.residual = std::max(system.residual, broadcast_blackred(sor_step<System>, parity, system.p.range, system, S.omega));
+    auto* comm_black = new BasicCommBuffer<T>(system.p, system.p.boundary.all, Partitioning::getCommunicator(), system.partitioning);
     delete comm_black;
-    broadcast_blackred(sor_step, !parity, system.p.range, system);
-    MPI_COMM_BUFFER* comm_red = new MPI_COMM_BUFFER(system.p, system.p.boundary.all, MPI_COMM_WORLD, system.partitioning);
+    system.residual = std::max(system.residual, broadcast_blackred(sor_step<System>, !parity, system.p.range, system, S.omega));
+    auto* comm_red = new BasicCommBuffer<T>(system.p, system.p.boundary.all, Partitioning::getCommunicator(), system.partitioning);
     delete comm_red;
 
-    double local_residual = system.residual;
-    double global_residual = 0.;
-    MPI_Allreduce(&local_residual, &global_residual, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
-
-    if (global_residual > 1e16)
+    bool converged = S.monitor.converged(iter, system.residual);
+    if (!S.monitor.checked(iter))
+      continue;
+    if (S.monitor.residual > 1e16)
     {
-      ErrorF("residual exploded {}", global_residual);
+      ErrorF("residual exploded {}", S.monitor.residual);
 
       for (int i = 0; i < system.partitioning.size; i++)
       {
@@ -147,8 +251,10 @@ void solve(SORSolver& S, PDESystem& system)
       }
       abort();
     }
+    if (Settings::get().adaptiveOmega)
+      adapt_omega(S, S.monitor.rate);
 
-    if (iter % 10 && global_residual < Settings::get().epsilon)
+    if (converged)
     {
       // std::cout << "COnverged after N=" << iter << " Iterations" << std::endl;
 
@@ -157,38 +263,1874 @@ void solve(SORSolver& S, PDESystem& system)
       break;
     }
   }
+  S.monitor.finish();
+}
+
+void solve(SORSolver& S, PDESystem& system)
+{
+  // global colouring, otherwise cells of the same colour meet at subdomain borders
+  sor(S, system, blackred_parity(system.partitioning, 0));
+}
+
+void solve(MixedPrecisionSolver& S, PDESystem& system)
+{
+  LaplaceMatrixOperator A = LaplaceMatrixOperator(system.h);
+  BasicResidualSystem<float> correction_system = { S.correction, S.residual, system.h, system.partitioning };
+  int parity = blackred_parity(system.partitioning, 0);
+  double epsilon = Settings::get().epsilon;
+  for (int refinement = 0; refinement < Settings::get().maximumNumberOfIterations; refinement++)
+  {
+    ProfileScope("Mixed Precision Refinement");
+    broadcast_boundary(copy_with_offset, system.partitioning, system.p.boundary, system.p);
+    MPI_COMM_BUFFER* comm_buffer = new MPI_COMM_BUFFER(system.p, system.p.boundary.all, Partitioning::getCommunicator(), system.partitioning);
+    delete comm_buffer;
+    // the residual of the double precision pressure is the right hand side of the correction
+    double residual = distributed_max(mixed_residual, system.p.range, S.residual, A, system.p, system.rhs);
+    if (residual < epsilon)
+      break;
+    // single precision resolves the correction to a few digits only, every refinement gains about four
+    S.sor.monitor.epsilon = std::max(epsilon, 1e-4 * residual);
+    S.correction.fill(0.f);
+    sor(S.sor, correction_system, parity);
+    parallel_broadcast(add_correction, system.p.range, system.p, S.correction);
+  }
+}
+
+// halo of `width` layers around the interior of a widened grid, exchanged in x first so that the
+// y exchange carries the corners
+static void wide_halos(Range interior, int width, std::array<std::tuple<Range, Offset>, 4>& x_halo, std::array<std::tuple<Range, Offset>, 4>& y_halo)
+{
+  Index lo = interior.begin;
+  Index hi = interior.end;
+  uint16_t w = width;
+  Range none = { lo, Index { static_cast<uint16_t>(lo.x - 1), lo.y } };
+  Range left = { { static_cast<uint16_t>(lo.x - w), lo.y }, { static_cast<uint16_t>(lo.x - 1), hi.y } };
+  Range right = { { static_cast<uint16_t>(hi.x + 1), lo.y }, { static_cast<uint16_t>(hi.x + w), hi.y } };
+  Range top = { { static_cast<uint16_t>(lo.x - w), static_cast<uint16_t>(hi.y + 1) }, { static_cast<uint16_t>(hi.x + w), static_cast<uint16_t>(hi.y + w) } };
+  Range bottom = { { static_cast<uint16_t>(lo.x - w), static_cast<uint16_t>(lo.y - w) }, { static_cast<uint16_t>(hi.x + w), static_cast<uint16_t>(lo.y - 1) } };
+  x_halo = { std::tuple<Range, Offset> { none, width * Iy }, { none, -width * Iy }, { left, -width * Ix }, { right, width * Ix } };
+  y_halo = { std::tuple<Range, Offset> { top, width * Iy }, { bottom, -width * Iy }, { none, -width * Ix }, { none, width * Ix } };
+}
+
+// the interior extended by w cells towards every neighbouring rank
+static Range extended_range(Range interior, const Partitioning::MPIInfo& partitioning, int w)
+{
+  Range r = interior;
+  if (partitioning.left_neighbor >= 0)
+    r.begin.x -= w;
+  if (partitioning.bottom_neighbor >= 0)
+    r.begin.y -= w;
+  if (partitioning.right_neighbor >= 0)
+    r.end.x += w;
+  if (partitioning.top_neighbor >= 0)
+    r.end.y += w;
+  return r;
+}
+
+static void exchange_wide_halo(Grid2D& grid, TemporalBlocking& B, Partitioning::MPIInfo& partitioning)
+{
+  for (auto& halo : { B.x_halo, B.y_halo })
+  {
+    MPI_COMM_BUFFER* comm_buffer = new MPI_COMM_BUFFER(grid, halo, Partitioning::getCommunicator(), partitioning);
+    delete comm_buffer;
+  }
+}
+
+TemporalBlocking::TemporalBlocking(PDESystem& system, int depth, int width)
+  : depth(depth)
+  , width(width)
+  , shift { width, width }
+  , interior { system.p.begin + shift, system.p.end + shift }
+  , p(system.p.begin, interior.end + shift)
+  , tmp(system.p.begin, interior.end + shift)
+  , rhs(system.p.begin, interior.end + shift)
+  , residual(system.p.begin, interior.end + shift)
+{
+  if (system.partitioning.nCells[0] < width || system.partitioning.nCells[1] < width)
+  {
+    ErrorF("temporal blocking needs at least {} cells per rank and direction", width);
+    abort();
+  }
+  wide_halos(interior, width, x_halo, y_halo);
+}
+
+// neumann ghosts of row j after its last update in an iteration, the next iteration reads them
+static void copy_ghosts(Grid2D& p, const TemporalBlocking& B, const Partitioning::MPIInfo& partitioning, uint16_t j)
+{
+  const Range& r = B.interior;
+  if (partitioning.left_neighbor < 0)
+    p[Index { static_cast<uint16_t>(r.begin.x - 1), j }] = p[Index { r.begin.x, j }];
+  if (partitioning.right_neighbor < 0)
+    p[Index { static_cast<uint16_t>(r.end.x + 1), j }] = p[Index { r.end.x, j }];
+  Offset row = { 0, 0 };
+  if (j == r.begin.y && partitioning.bottom_neighbor < 0)
+    row = -Iy;
+  else if (j == r.end.y && partitioning.top_neighbor < 0)
+    row = Iy;
+  else
+    return;
+  for (uint16_t i = r.begin.x - B.width; i <= r.end.x + B.width; i++)
+    p[Index { i, j } + row] = p[Index { i, j }];
+}
+
+// the pressure and the right hand side move into the widened grids for the whole solve
+static void enter_blocking(TemporalBlocking& B, PDESystem& system)
+{
+  for (uint16_t j = system.p.begin.y; j <= system.p.end.y; j++)
+  {
+    for (uint16_t i = system.p.begin.x; i <= system.p.end.x; i++)
+    {
+      B.p[Index { i, j } + B.shift] = system.p[Index { i, j }];
+      B.rhs[Index { i, j } + B.shift] = system.rhs[Index { i, j }];
+    }
+  }
+  exchange_wide_halo(B.rhs, B, system.partitioning);
+  parallel_broadcast(set, B.interior, Offset { 0, 0 }, B.residual, INFINITY);
+}
+
+static void leave_blocking(TemporalBlocking& B, PDESystem& system)
+{
+  for (uint16_t j = system.p.begin.y; j <= system.p.end.y; j++)
+  {
+    for (uint16_t i = system.p.begin.x; i <= system.p.end.x; i++)
+      system.p[Index { i, j }] = B.p[Index { i, j } + B.shift];
+  }
+  broadcast_boundary(copy_with_offset, system.partitioning, system.p.boundary, system.p);
+  MPI_COMM_BUFFER* comm_buffer = new MPI_COMM_BUFFER(system.p, system.p.boundary.all, Partitioning::getCommunicator(), system.partitioning);
+  delete comm_buffer;
+}
+
+// B.depth black-red iterations after one halo exchange. Iteration s updates the first colour of row
+// t - 2s and then the second colour of the row below, which keeps the order of every dependent pair
+// of updates the same as in consecutive full sweeps
+static void blocked_black_red(TemporalBlocking& B, PDESystem& system, int parity)
+{
+  ProfileScope("Blocked Black Red");
+  exchange_wide_halo(B.p, B, system.partitioning);
+  broadcast_boundary(copy_with_offset, system.partitioning, Boundaries(B.interior.begin, B.interior.end), B.p);
+  ResidualSystem wide = { B.p, B.rhs, system.h, system.partitioning };
+  // colour of a cell, 0 for the cells of the first half sweep
+  int base = 4 * B.width + parity - B.interior.begin.x - B.interior.begin.y;
+  auto sweep_row = [&](int half, int j) {
+    Range r = extended_range(B.interior, system.partitioning, B.width - 1 - half);
+    if (j < r.begin.y || j > r.end.y)
+      return;
+    int colour = half % 2;
+    uint16_t first = r.begin.x + ((r.begin.x + j + base + colour) & 1);
+    for (uint16_t i = first; i <= r.end.x; i += 2)
+    {
+      Index I = { i, static_cast<uint16_t>(j) };
+      auto [update, res] = jacoby_update(I, wide);
+      B.residual[I] = res;
+      B.p[I] = update;
+    }
+    if (colour == 1)
+      copy_ghosts(B.p, B, system.partitioning, j);
+  };
+  Range outer = extended_range(B.interior, system.partitioning, B.width - 1);
+  for (int t = outer.begin.y; t <= outer.end.y + 2 * B.depth - 1; t++)
+  {
+    for (int s = 0; s < B.depth; s++)
+    {
+      sweep_row(2 * s, t - 2 * s);
+      sweep_row(2 * s + 1, t - 2 * s - 1);
+    }
+  }
+}
+
+// B.depth jacobi iterations after one halo exchange, alternating between B.p and B.tmp. Iteration s
+// runs two rows behind iteration s - 1, so it never overwrites a row that is still going to be read
+static void blocked_jacobi(TemporalBlocking& B, PDESystem& system)
+{
+  ProfileScope("Blocked Jacobi");
+  exchange_wide_halo(B.p, B, system.partitioning);
+  broadcast_boundary(copy_with_offset, system.partitioning, Boundaries(B.interior.begin, B.interior.end), B.p);
+  ResidualSystem even = { B.p, B.rhs, system.h, system.partitioning };
+  ResidualSystem odd = { B.tmp, B.rhs, system.h, system.partitioning };
+  Range outer = extended_range(B.interior, system.partitioning, B.width - 1);
+  for (int t = outer.begin.y; t <= outer.end.y + 2 * (B.depth - 1); t++)
+  {
+    for (int s = 0; s < B.depth; s++)
+    {
+      Range r = extended_range(B.interior, system.partitioning, B.width - 1 - s);
+      int j = t - 2 * s;
+      if (j < r.begin.y || j > r.end.y)
+        continue;
+      ResidualSystem& in = (s % 2 == 0) ? even : odd;
+      Grid2D& out = (s % 2 == 0) ? B.tmp : B.p;
+#pragma omp simd
+      for (uint16_t i = r.begin.x; i <= r.end.x; i++)
+      {
+        Index I = { i, static_cast<uint16_t>(j) };
+        auto [update, res] = jacoby_update(I, in);
+        B.residual[I] = res;
+        out[I] = update;
+      }
+      copy_ghosts(out, B, system.partitioning, j);
+    }
+  }
+  if (B.depth % 2 == 1)
+    std::swap(B.p, B.tmp);
+}
+
+static void solve_blocked(TemporalBlocking& B, ConvergenceMonitor& monitor, PDESystem& system, bool black_red)
+{
+  enter_blocking(B, system);
+  int parity = blackred_parity(system.partitioning, 0);
+  for (int iter = B.depth - 1; iter < Settings::get().maximumNumberOfIterations; iter += B.depth)
+  {
+    if (black_red)
+      blocked_black_red(B, system, parity);
+    else
+      blocked_jacobi(B, system);
+    double local_residual = monitor.due(iter) ? maximum(absolute, B.interior, B.residual) : 0.;
+    if (monitor.converged(iter, local_residual))
+      break;
+  }
+  leave_blocking(B, system);
 }
+
 void solve(BlackRedSolver& S, PDESystem& system)
 {
+  if (S.blocking)
+  {
+    S.monitor.start();
+    solve_blocked(*S.blocking, S.monitor, system, true);
+    S.monitor.finish();
+    return;
+  }
   system.residual = 0;
   parallel_broadcast(set, system.p.range, Offset { 0, 0 }, S.residual, INFINITY);
+  // global colouring, otherwise cells of the same colour meet at subdomain borders
+  int parity = blackred_parity(system.partitioning, 0);
+  S.monitor.start();
   for (int iter = 0; iter < Settings::get().maximumNumberOfIterations; iter++)
   {
     broadcast_boundary(copy_with_offset, system.partitioning, system.p.boundary, system.p);
-    broadcast_blackred(black_red_step, 0, system.p.range, system, S);
-    broadcast_blackred(black_red_step, 1, system.p.range, system, S);
-    if (iter % 100 && S.residual.max() < Settings::get().epsilon)
+    broadcast_blackred(black_red_step<PDESystem>, parity, system.p.range, system, S);
+    MPI_COMM_BUFFER* comm_black = new MPI_COMM_BUFFER(system.p, system.p.boundary.all, Partitioning::getCommunicator(), system.partitioning);
+    delete comm_black;
+    broadcast_blackred(black_red_step<PDESystem>, !parity, system.p.range, system, S);
+    MPI_COMM_BUFFER* comm_red = new MPI_COMM_BUFFER(system.p, system.p.boundary.all, Partitioning::getCommunicator(), system.partitioning);
+    delete comm_red;
+    // the local maximum is only formed for the sweeps that are reduced
+    double local_residual = S.monitor.due(iter) ? maximum(absolute, system.p.range, S.residual) : 0.;
+    if (S.monitor.converged(iter, local_residual))
     {
-
-      DebugF("Residual {:.14e} \nBlack Red converged after n={}", S.residual.max(), iter);
+      DebugF("Residual {:.14e} \nBlack Red converged after n={}", S.monitor.residual, iter);
       break;
     }
   }
+  S.monitor.finish();
 }
 
 void solve(Jacoby& S, PDESystem& system)
 {
+  if (S.blocking)
+  {
+    S.monitor.start();
+    solve_blocked(*S.blocking, S.monitor, system, false);
+    S.monitor.finish();
+    return;
+  }
   system.residual = 0;
   parallel_broadcast(set, system.p.range, Offset { 0, 0 }, S.residual, INFINITY);
+  S.monitor.start();
   for (int iter = 0; iter < Settings::get().maximumNumberOfIterations; iter++)
   {
     broadcast_boundary(copy_with_offset, system.partitioning, system.p.boundary, system.p);
     test_broadcast(jacoby_step, system.p.range, system, S);
     std::swap(system.p, S.tmp);
-    if (iter % 100 && S.residual.max() < Settings::get().epsilon)
+    MPI_COMM_BUFFER* comm_buffer = new MPI_COMM_BUFFER(system.p, system.p.boundary.all, Partitioning::getCommunicator(), system.partitioning);
+    delete comm_buffer;
+    double local_residual = S.monitor.due(iter) ? maximum(absolute, system.p.range, S.residual) : 0.;
+    if (S.monitor.converged(iter, local_residual))
+    {
+      DebugF("Residual {:.14e} \nJacobi converged after n={}", S.monitor.residual, iter);
+      break;
+    }
+  }
+  S.monitor.finish();
+}
+
+// dense LU factorization with partial pivoting, row major n x n
+static void lu_factor(std::vector<double>& M, std::vector<int>& pivots, int n)
+{
+  for (int k = 0; k < n; k++)
+  {
+    int pivot = k;
+    for (int i = k + 1; i < n; i++)
+    {
+      if (std::abs(M[i * n + k]) > std::abs(M[pivot * n + k]))
+        pivot = i;
+    }
+    pivots[k] = pivot;
+    if (pivot != k)
+    {
+      for (int j = 0; j < n; j++)
+        std::swap(M[k * n + j], M[pivot * n + j]);
+    }
+    for (int i = k + 1; i < n; i++)
+    {
+      M[i * n + k] /= M[k * n + k];
+      for (int j = k + 1; j < n; j++)
+        M[i * n + j] -= M[i * n + k] * M[k * n + j];
+    }
+  }
+}
+
+static void lu_solve(const std::vector<double>& M, const std::vector<int>& pivots, int n, double* b)
+{
+  for (int k = 0; k < n; k++)
+  {
+    std::swap(b[k], b[pivots[k]]);
+    for (int i = k + 1; i < n; i++)
+      b[i] -= M[i * n + k] * b[k];
+  }
+  for (int k = n - 1; k >= 0; k--)
+  {
+    for (int j = k + 1; j < n; j++)
+      b[k] -= M[k * n + j] * b[j];
+    b[k] /= M[k * n + k];
+  }
+}
+
+CoarseCorrection::CoarseCorrection(PDESystem& system)
+  : sums(system.partitioning.size)
+  , values(system.partitioning.size)
+{
+  ProfileScope("Coarse Space Setup");
+  const Partitioning::MPIInfo& info = system.partitioning;
+  int size = info.size;
+  // 1_k^T A 1_l counts the faces shared by the subdomains k and l
+  std::vector<double> row(size, 0.);
+  double faces[4] = { info.nCells[0] / system.h.y_squared, info.nCells[0] / system.h.y_squared,
+    info.nCells[1] / system.h.x_squared, info.nCells[1] / system.h.x_squared };
+  for (int i = 0; i < 4; i++)
+  {
+    int neighbour = info.neighbours()[i][0];
+    if (neighbour < 0)
+      continue;
+    row[neighbour] += faces[i];
+    row[info.rank] -= faces[i];
+  }
+  galerkin.resize(size * size);
+  MPI_Allgather(row.data(), size, MPI_DOUBLE, galerkin.data(), size, MPI_DOUBLE, Partitioning::getCommunicator());
+  // E is singular like A, the rank one term fixes the mean of the coarse values
+  double diagonal = 0.;
+  for (int k = 0; k < size; k++)
+    diagonal += galerkin[k * size + k] / size;
+  for (int k = 0; k < size * size; k++)
+    galerkin[k] += diagonal / size;
+  pivots.resize(size);
+  lu_factor(galerkin, pivots, size);
+}
+
+double coarse_correction(CoarseCorrection& C, PDESystem& system, const Grid2D& r, Grid2D& z)
+{
+  ProfileScope("Coarse Correction");
+  int size = system.partitioning.size;
+  double local = sum(value, system.p.range, r);
+  MPI_Allgather(&local, 1, MPI_DOUBLE, C.sums.data(), 1, MPI_DOUBLE, Partitioning::getCommunicator());
+  C.values = C.sums;
+  lu_solve(C.galerkin, C.pivots, size, C.values.data());
+  parallel_broadcast(add_constant, system.p.range, z, C.values[system.partitioning.rank]);
+  // r^T Z E^-1 Z^T r, known on every rank without another reduction
+  double rz = 0.;
+  for (int k = 0; k < size; k++)
+    rz += C.sums[k] * C.values[k];
+  return rz;
+}
+
+LineSolver::LineSolver(Offset along, Index begin, Index end, const Gridsize& h, const Partitioning::MPIInfo& partitioning, int level)
+  : along(along)
+  , across(along == Ix ? Iy : Ix)
+  , length(along == Ix ? end.x - begin.x + 1 : end.y - begin.y + 1)
+  , lines(along == Ix ? end.y - begin.y + 1 : end.x - begin.x + 1)
+  , coupling(along == Ix ? 1. / h.x_squared : 1. / h.y_squared)
+  , cross(along == Ix ? 1. / h.y_squared : 1. / h.x_squared)
+  , elimination(length)
+  , inverse_pivot(length)
+  , left(length, 0.)
+  , right(length, 0.)
+  , ends(lines + 1)
+{
+  assert(length > 1 && "a line segment needs distinct first and last cells");
+  Index pos = partitioning.getGridPos();
+  // lines along x are rows, their colour is the parity of the global row
+  Index offset = cell_offset(partitioning, level);
+  parity = (along == Ix ? offset.y : offset.x) % 2;
+  bool previous = (along == Ix ? partitioning.left_neighbor : partitioning.bottom_neighbor) >= 0;
+  bool next = (along == Ix ? partitioning.right_neighbor : partitioning.top_neighbor) >= 0;
+
+  // Neumann ends are folded into the diagonal, segment ends at other ranks couple through the reduced system
+  double diagonal = -2. * coupling - 2. * cross;
+  double pivot = 0.;
+  for (int i = 0; i < length; i++)
+  {
+    double a = diagonal;
+    if ((i == 0 && !previous) || (i == length - 1 && !next))
+      a += coupling;
+    elimination[i] = (i == 0) ? 0. : coupling / pivot;
+    pivot = a - elimination[i] * coupling;
+    inverse_pivot[i] = 1. / pivot;
+  }
+  auto thomas = [&](std::vector<double>& x) {
+    for (int i = 1; i < length; i++)
+      x[i] -= elimination[i] * x[i - 1];
+    x[length - 1] *= inverse_pivot[length - 1];
+    for (int i = length - 2; i >= 0; i--)
+      x[i] = (x[i] - coupling * x[i + 1]) * inverse_pivot[i];
+  };
+  if (previous)
+  {
+    left[0] = -coupling;
+    thomas(left);
+  }
+  if (next)
+  {
+    right[length - 1] = -coupling;
+    thomas(right);
+  }
+
+  // the grid row of a rank counts downwards, the bottom neighbour is the next row
+  MPI_Comm_split(Partitioning::getCommunicator(), along == Ix ? pos.y : pos.x, along == Ix ? pos.x : partitioning.Partitions[1] - 1 - pos.y, &comm);
+  MPI_Comm_rank(comm, &position);
+  MPI_Comm_size(comm, &ranks);
+  if (ranks == 1)
+    return;
+
+  // x_first^k = y_first^k + left_first^k x_last^(k-1) + right_first^k x_first^(k+1), the same for x_last^k
+  std::array<double, 4> local = { left[0], left[length - 1], right[0], right[length - 1] };
+  std::vector<double> responses(4 * ranks);
+  MPI_Allgather(local.data(), 4, MPI_DOUBLE, responses.data(), 4, MPI_DOUBLE, comm);
+  int n = 2 * ranks;
+  reduced.assign(n * n, 0.);
+  pivots.resize(n);
+  for (int k = 0; k < ranks; k++)
+  {
+    for (int end = 0; end < 2; end++)
+    {
+      int row = 2 * k + end;
+      reduced[row * n + row] = 1.;
+      if (k > 0)
+        reduced[row * n + 2 * (k - 1) + 1] = -responses[4 * k + end];
+      if (k < ranks - 1)
+        reduced[row * n + 2 * (k + 1)] = -responses[4 * k + 2 + end];
+    }
+  }
+  lu_factor(reduced, pivots, n);
+  ends.resize(2 * lines);
+  all_ends.resize(2 * lines * ranks);
+  end_values.resize(n);
+}
+
+ZebraSolver::ZebraSolver(PDESystem& system)
+  : ZebraSolver(system.p.begin, system.p.end, system.h, system.partitioning, 0)
+{
+}
+
+ZebraSolver::ZebraSolver(Index begin, Index end, const Gridsize& h, const Partitioning::MPIInfo& partitioning, int level)
+  : rows(Ix, begin, end, h, partitioning, level)
+  , columns(Iy, begin, end, h, partitioning, level)
+  , monitor(Settings::get().epsilon)
+{
+}
+
+// solves all local lines of one colour, the lines of the other colour are fixed
+template <typename System>
+static void relax_lines(System& system, LineSolver& L, int colour)
+{
+  ProfileScope("Line Relaxation");
+  auto& p = system.p;
+  const Index begin = system.p.range.begin;
+  const Index last = begin + (L.length - 1) * L.along;
+  int count = 0;
+  for (int line = (colour + L.parity) % 2; line < L.lines; line += 2, count++)
+  {
+    Index I = begin + line * L.across;
+    // forward elimination, the eliminated right hand side is kept in p
+    double previous = 0.;
+    for (int i = 0; i < L.length; i++, I = I + L.along)
+    {
+      previous = system.rhs[I] - L.cross * (p[I - L.across] + p[I + L.across]) - L.elimination[i] * previous;
+      p[I] = previous;
+    }
+    double next = 0.;
+    for (int i = L.length - 1; i >= 0; i--)
+    {
+      I = I - L.along;
+      next = (p[I] - L.coupling * next) * L.inverse_pivot[i];
+      p[I] = next;
+    }
+    if (L.ranks > 1)
+    {
+      L.ends[2 * count] = p[I];
+      L.ends[2 * count + 1] = p[last + line * L.across];
+    }
+  }
+  if (L.ranks == 1)
+    return;
+
+  // one allgather for all lines of the colour, the ends of rank k start at 2 * count * k
+  MPI_Allgather(L.ends.data(), 2 * count, MPI_DOUBLE, L.all_ends.data(), 2 * count, MPI_DOUBLE, L.comm);
+  int segment = 0;
+  for (int line = (colour + L.parity) % 2; line < L.lines; line += 2, segment++)
+  {
+    for (int k = 0; k < L.ranks; k++)
+    {
+      L.end_values[2 * k] = L.all_ends[2 * (count * k + segment)];
+      L.end_values[2 * k + 1] = L.all_ends[2 * (count * k + segment) + 1];
+    }
+    lu_solve(L.reduced, L.pivots, 2 * L.ranks, L.end_values.data());
+    double previous_end = L.position > 0 ? L.end_values[2 * (L.position - 1) + 1] : 0.;
+    double next_start = L.position < L.ranks - 1 ? L.end_values[2 * (L.position + 1)] : 0.;
+    Index I = begin + line * L.across;
+    for (int i = 0; i < L.length; i++, I = I + L.along)
+      p[I] += L.left[i] * previous_end + L.right[i] * next_start;
+  }
+}
+
+// rows then columns, parity 1 reverses the order of the directions and colours so that a
+// pre- and a post-smoothing sweep form a symmetric pair
+template <typename System>
+static void zebra_sweep(System& system, ZebraSolver& Z, int parity)
+{
+  for (int direction = 0; direction < 2; direction++)
+  {
+    LineSolver& L = (direction == parity) ? Z.rows : Z.columns;
+    for (int colour = 0; colour < 2; colour++)
     {
-      DebugF("Residual {:.14e} \nJacobi converged after n={}", S.residual.max(), iter);
+      broadcast_boundary(copy_with_offset, system.partitioning, system.p.boundary, system.p);
+      relax_lines(system, L, colour ^ parity);
+      MPI_COMM_BUFFER* comm_buffer = new MPI_COMM_BUFFER(system.p, system.p.boundary.all, Partitioning::getCommunicator(), system.partitioning);
+      delete comm_buffer;
+    }
+  }
+}
+
+void solve(ZebraSolver& Z, PDESystem& system)
+{
+  LaplaceMatrixOperator A = LaplaceMatrixOperator(system.h);
+  Z.monitor.start();
+  for (int iter = 0; iter < Settings::get().maximumNumberOfIterations; iter++)
+  {
+    ProfileScope("Zebra Iteration");
+    zebra_sweep(system, Z, 0);
+    broadcast_boundary(copy_with_offset, system.partitioning, system.p.boundary, system.p);
+    // the residual is only formed for the sweeps that are reduced
+    double local_residual = Z.monitor.due(iter) ? maximum(laplace_residual, system.p.range, A, system.p, system.rhs) : 0.;
+    if (Z.monitor.converged(iter, local_residual))
+      break;
+  }
+  Z.monitor.finish();
+}
+
+MultigridSolver::MultigridSolver(PDESystem& system)
+  : defect(system.p.begin, system.p.end)
+  , smoother(system.p.begin, system.p.end, system.h, system.partitioning, 0, system.settings.nCells[0], system.settings.nCells[1])
+  , parity(blackred_parity(system.partitioning, 0))
+{
+  Partitioning::MPIInfo info = system.partitioning;
+  double hx = system.h.x;
+  double hy = system.h.y;
+  int nx = system.settings.nCells[0];
+  int ny = system.settings.nCells[1];
+  for (int level = 1;; level++)
+  {
+    // every rank has to be able to halve its subdomain, otherwise the levels don't match up
+    int local_coarsening = info.nCells[0] % 2 == 0 && info.nCells[1] % 2 == 0 && info.nCells[0] >= 4 && info.nCells[1] >= 4;
+    int coarsening = 0;
+    MPI_Allreduce(&local_coarsening, &coarsening, 1, MPI_INT, MPI_MIN, Partitioning::getCommunicator());
+    if (!coarsening)
+      break;
+    info.nCells[0] /= 2;
+    info.nCells[1] /= 2;
+    info.nCellsWithGhostcells[0] = info.nCells[0] + 2;
+    info.nCellsWithGhostcells[1] = info.nCells[1] + 2;
+    hx *= 2;
+    hy *= 2;
+    nx /= 2;
+    ny /= 2;
+    levels.emplace_back(Index(info.nCells[0] + 1, info.nCells[1] + 1), Gridsize(hx, hy), info, blackred_parity(info, level), level, nx, ny);
+  }
+  // a chebyshev coarse solve has to cover the whole nonzero spectrum
+  ChebyshevSolver& coarsest = levels.empty() ? smoother.chebyshev : levels.back().smoother.chebyshev;
+  coarsest.upper = LaplaceMatrixOperator(Gridsize(hx, hy)).spectrum(nx, ny).second;
+  if (levels.empty())
+    WarningF("Multigrid could not coarsen {}x{} cells per rank, falling back to plain smoothing", system.partitioning.nCells[0], system.partitioning.nCells[1]);
+}
+
+// Neumann ghosts and halo, exchanged twice so that the corner ghosts are valid for the prolongation
+static void update_ghosts(Grid2D& grid, Partitioning::MPIInfo& partitioning)
+{
+  for (int pass = 0; pass < 2; pass++)
+  {
+    broadcast_boundary(copy_with_offset, partitioning, grid.boundary, grid);
+    MPI_COMM_BUFFER* comm = new MPI_COMM_BUFFER(grid, grid.boundary.all, Partitioning::getCommunicator(), partitioning);
+    delete comm;
+  }
+}
+
+// chebyshev semi iteration starting from system.p, converged(iter, S) is asked after every iteration
+template <typename System, typename Check>
+static void chebyshev(System& system, ChebyshevSolver& S, int iterations, Check&& converged)
+{
+  LaplaceMatrixOperator A = LaplaceMatrixOperator(system.h);
+  const double theta = (S.lower + S.upper) / 2.;
+  const double delta = (S.upper - S.lower) / 2.;
+  const double sigma = theta / delta;
+  double rho = 1. / sigma;
+
+  // r = rhs - A p, d = r / theta
+  broadcast_boundary(copy_with_offset, system.partitioning, system.p.boundary, system.p);
+  broadcast_rows(aAxpy_row, system.p.range, S.residual, -1., A, system.p, system.rhs);
+  parallel_broadcast(scale, system.p.range, S.direction, 1. / theta, S.residual);
+  for (int iter = 0; iter < iterations; iter++)
+  {
+    ProfileScope("Chebyshev Iteration");
+    broadcast_boundary(copy_with_offset, system.partitioning, S.direction.boundary, S.direction);
+    stencil_broadcast(chebyshev_step, system.partitioning, system.p.range, S.direction, system.p, S.residual, A, S.direction);
+    if (converged(iter, S))
       break;
+    double rho_next = 1. / (2. * sigma - rho);
+    parallel_broadcast(axpby, system.p.range, S.direction, rho_next * rho, S.direction, 2. * rho_next / delta, S.residual);
+    rho = rho_next;
+  }
+  // the updates ran on the inner cells only, the neighbours need the new border values
+  broadcast_boundary(copy_with_offset, system.partitioning, system.p.boundary, system.p);
+  MPI_COMM_BUFFER* comm_buffer = new MPI_COMM_BUFFER(system.p, system.p.boundary.all, Partitioning::getCommunicator(), system.partitioning);
+  delete comm_buffer;
+}
+
+template <typename System>
+static void smooth(System& system, MultigridSmoother& smoother, int parity, int sweeps)
+{
+  ProfileScope("Multigrid Smoothing");
+  if (Settings::get().multigridSmoother == Settings::Chebyshev)
+  {
+    // a polynomial in A, symmetric in either colour order
+    chebyshev(system, smoother.chebyshev, sweeps, [](int, ChebyshevSolver&) { return false; });
+    return;
+  }
+  if (Settings::get().multigridSmoother == Settings::Zebra)
+  {
+    // the line colours are global already, the order flag has to agree on all ranks since every
+    // colour ends in a collective on the row or column communicator
+    for (int sweep = 0; sweep < sweeps; sweep++)
+      zebra_sweep(system, *smoother.zebra, parity ^ smoother.parity);
+    broadcast_boundary(copy_with_offset, system.partitioning, system.p.boundary, system.p);
+    return;
+  }
+  for (int sweep = 0; sweep < sweeps; sweep++)
+  {
+    system.residual = 0;
+    broadcast_boundary(copy_with_offset, system.partitioning, system.p.boundary, system.p);
+    if (Settings::get().multigridSmoother == Settings::SOR)
+      system.residual = std::max(system.residual, broadcast_blackred(sor_step<System>, parity, system.p.range, system, Settings::get().omega));
+    else
+      broadcast_blackred(black_red_step<System>, parity, system.p.range, system, smoother.blackred);
+    MPI_COMM_BUFFER* comm_black = new MPI_COMM_BUFFER(system.p, system.p.boundary.all, Partitioning::getCommunicator(), system.partitioning);
+    delete comm_black;
+    if (Settings::get().multigridSmoother == Settings::SOR)
+      system.residual = std::max(system.residual, broadcast_blackred(sor_step<System>, !parity, system.p.range, system, Settings::get().omega));
+    else
+      broadcast_blackred(black_red_step<System>, !parity, system.p.range, system, smoother.blackred);
+    MPI_COMM_BUFFER* comm_red = new MPI_COMM_BUFFER(system.p, system.p.boundary.all, Partitioning::getCommunicator(), system.partitioning);
+    delete comm_red;
+  }
+  broadcast_boundary(copy_with_offset, system.partitioning, system.p.boundary, system.p);
+}
+
+template <typename System>
+static void cycle(MultigridSolver& mg, System& fine, MultigridSmoother& smoother, Grid2D& defect, int parity, size_t coarse, Settings::MultigridCycle type)
+{
+  const Settings& settings = Settings::get();
+  if (coarse == mg.levels.size())
+  {
+    ProfileScope("Multigrid Coarse Solve");
+    if (!mg.symmetric || settings.multigridSmoother == Settings::Chebyshev)
+    {
+      smooth(fine, smoother, parity, settings.multigridCoarseIterations);
+      return;
     }
+    // pairs of forward and backward sweeps keep the coarse solve symmetric, an odd number of
+    // iterations is rounded up to the next full pair
+    for (int pair = 0; pair < (settings.multigridCoarseIterations + 1) / 2; pair++)
+    {
+      smooth(fine, smoother, parity, 1);
+      smooth(fine, smoother, !parity, 1);
+    }
+    return;
+  }
+  smooth(fine, smoother, parity, settings.multigridPreSmoothing);
+
+  MultigridLevel& level = mg.levels[coarse];
+  LaplaceMatrixOperator A = LaplaceMatrixOperator(fine.h);
+  ProfilePush("Multigrid Restriction");
+  // defect = rhs - A*p
+  broadcast_rows(aAxpy_row, fine.p.range, defect, -1., A, fine.p, fine.rhs);
+  if (mg.symmetric)
+  {
+    update_ghosts(defect, fine.partitioning);
+    parallel_broadcast(restrict_full_weighting, level.p.range, defect, level.rhs);
+  } else
+  {
+    parallel_broadcast(restrict_defect, level.p.range, defect, level.rhs);
+  }
+  // ghosts included, the first sweep on the coarse level reads the halo before any exchange
+  parallel_broadcast(set, Range { level.p.begin - II, level.p.end + II }, Offset { 0, 0 }, level.p, 0.);
+  ProfilePop();
+
+  switch (type)
+  {
+  case Settings::VCycle:
+    cycle(mg, level, level.smoother, level.defect, level.parity, coarse + 1, Settings::VCycle);
+    break;
+  case Settings::WCycle:
+    cycle(mg, level, level.smoother, level.defect, level.parity, coarse + 1, Settings::WCycle);
+    cycle(mg, level, level.smoother, level.defect, level.parity, coarse + 1, Settings::WCycle);
+    break;
+  case Settings::FCycle:
+    cycle(mg, level, level.smoother, level.defect, level.parity, coarse + 1, Settings::FCycle);
+    cycle(mg, level, level.smoother, level.defect, level.parity, coarse + 1, Settings::VCycle);
+    break;
+  }
+
+  ProfilePush("Multigrid Prolongation");
+  update_ghosts(level.p, level.partitioning);
+  parallel_broadcast(prolongate_correction, fine.p.range, level.p, fine.p);
+  // the corrected cells at the subdomain border are read by the first post smoothing sweep of the neighbour
+  MPI_COMM_BUFFER* comm = new MPI_COMM_BUFFER(fine.p, fine.p.boundary.all, Partitioning::getCommunicator(), fine.partitioning);
+  delete comm;
+  ProfilePop();
+
+  // reversed colour order makes the post smoothing the adjoint of the pre smoothing
+  smooth(fine, smoother, mg.symmetric ? !parity : parity, settings.multigridPostSmoothing);
+}
+
+void solve(MultigridSolver& mg, PDESystem& system)
+{
+  LaplaceMatrixOperator A = LaplaceMatrixOperator(system.h);
+  for (int iter = 0; iter < Settings::get().maximumNumberOfIterations; iter++)
+  {
+    ProfileScope("Multigrid Iteration");
+    cycle(mg, system, mg.smoother, mg.defect, mg.parity, 0, Settings::get().multigridCycle);
+
+    // smoothing leaves valid ghosts behind
+    broadcast_rows(aAxpy_row, system.p.range, mg.defect, -1., A, system.p, system.rhs);
+    double residual = norm_max(mg.defect);
+    if (residual > 1e16 || std::isnan(residual))
+    {
+      ErrorF("residual exploded {}", residual);
+      abort();
+    }
+    if (residual < Settings::get().epsilon)
+    {
+      // DebugF("Multigrid converged after {} cycles", iter);
+      break;
+    }
+  }
+}
+
+void precondition(JacobiPreconditioner& M, PDESystem& system, const Grid2D& r, Grid2D& z)
+{
+  parallel_broadcast(scale, system.p.range, z, 1. / LaplaceMatrixOperator(system.h).a_ij, r);
+}
+
+Preconditioner make_preconditioner(PDESystem& system)
+{
+  if (Settings::get().preconditioner == Settings::Preconditioner::Multigrid)
+    return Preconditioner(std::in_place_type<MultigridPreconditioner>, system);
+  if (Settings::get().preconditioner == Settings::Preconditioner::Chebyshev)
+    return Preconditioner(std::in_place_type<ChebyshevPreconditioner>, system);
+  if (Settings::get().preconditioner == Settings::Preconditioner::BlockJacobi)
+    return BlockJacobiPreconditioner {};
+  if (Settings::get().preconditioner == Settings::Preconditioner::SSOR)
+    return SSORPreconditioner {};
+  if (Settings::get().preconditioner == Settings::Preconditioner::IncompleteCholesky)
+    return Preconditioner(std::in_place_type<IncompleteCholeskyPreconditioner>, system);
+  if (Settings::get().preconditioner == Settings::Preconditioner::AMG)
+    return Preconditioner(std::in_place_type<AMGPreconditioner>, system);
+  return JacobiPreconditioner {};
+}
+
+// red-black SOR sweeps on A z = r from zero, each one forward and then in the reversed colour order
+// so that CG sees a symmetric preconditioner. Without the halo exchange the ghosts at the subdomain
+// interfaces stay zero
+static void symmetric_sor(PDESystem& system, const Grid2D& r, Grid2D& z, int parity, int sweeps, bool exchange)
+{
+  parallel_broadcast(set, Range { z.begin - II, z.end + II }, Offset { 0, 0 }, z, 0.);
+  ResidualSystem local = { z, r, system.h, system.partitioning };
+  double omega = Settings::get().adaptiveOmega ? 1. : Settings::get().omega;
+  for (int sweep = 0; sweep < sweeps; sweep++)
+  {
+    for (int colour : { parity, 1 - parity, 1 - parity, parity })
+    {
+      broadcast_boundary(copy_with_offset, system.partitioning, z.boundary, z);
+      broadcast_blackred(sor_step<ResidualSystem>, colour, z.range, local, omega);
+      if (exchange)
+      {
+        MPI_COMM_BUFFER* comm_buffer = new MPI_COMM_BUFFER(z, z.boundary.all, Partitioning::getCommunicator(), system.partitioning);
+        delete comm_buffer;
+      }
+    }
+  }
+  broadcast_boundary(copy_with_offset, system.partitioning, z.boundary, z);
+}
+
+void precondition(BlockJacobiPreconditioner& M, PDESystem& system, const Grid2D& r, Grid2D& z)
+{
+  // the zero ghosts at the interfaces are the dirichlet data of the local problems
+  symmetric_sor(system, r, z, 0, Settings::get().blockJacobiSweeps, false);
+}
+
+void precondition(SSORPreconditioner& M, PDESystem& system, const Grid2D& r, Grid2D& z)
+{
+  symmetric_sor(system, r, z, blackred_parity(system.partitioning, 0), 1, true);
+}
+
+IncompleteCholeskyPreconditioner::IncompleteCholeskyPreconditioner(PDESystem& system)
+  : inverse_pivot(system.p.begin, system.p.end)
+{
+  ProfileScope("Incomplete Cholesky Setup");
+  const Partitioning::MPIInfo& info = system.partitioning;
+  const Range r = system.p.range;
+  double bx = 1. / system.h.x_squared;
+  double by = 1. / system.h.y_squared;
+  for (uint16_t j = r.begin.y; j <= r.end.y; j++)
+  {
+    for (uint16_t i = r.begin.x; i <= r.end.x; i++)
+    {
+      Index I = { i, j };
+      // the neumann ghosts fold into the diagonal, interface ghosts are dropped
+      double pivot = 2. * bx + 2. * by;
+      if ((i == r.begin.x && info.left_neighbor < 0) || (i == r.end.x && info.right_neighbor < 0))
+        pivot -= bx;
+      if ((j == r.begin.y && info.bottom_neighbor < 0) || (j == r.end.y && info.top_neighbor < 0))
+        pivot -= by;
+      if (i > r.begin.x)
+        pivot -= bx * bx * inverse_pivot[I - Ix];
+      if (j > r.begin.y)
+        pivot -= by * by * inverse_pivot[I - Iy];
+      inverse_pivot[I] = 1. / pivot;
+    }
+  }
+}
+
+void precondition(IncompleteCholeskyPreconditioner& M, PDESystem& system, const Grid2D& r, Grid2D& z)
+{
+  const Range range = z.range;
+  double bx = 1. / system.h.x_squared;
+  double by = 1. / system.h.y_squared;
+  // zero ghosts drop the couplings outside the factorized block
+  parallel_broadcast(set, Range { z.begin - II, z.end + II }, Offset { 0, 0 }, z, 0.);
+  // (D + L) u = -r, then (D + L^T) z = D u, the sign turns -A back into A
+  for (uint16_t j = range.begin.y; j <= range.end.y; j++)
+  {
+    for (uint16_t i = range.begin.x; i <= range.end.x; i++)
+    {
+      Index I = { i, j };
+      z[I] = (bx * z[I - Ix] + by * z[I - Iy] - r[I]) * M.inverse_pivot[I];
+    }
+  }
+  for (uint16_t j = range.end.y; j >= range.begin.y; j--)
+  {
+    for (uint16_t i = range.end.x; i >= range.begin.x; i--)
+    {
+      Index I = { i, j };
+      z[I] += (bx * z[I + Ix] + by * z[I + Iy]) * M.inverse_pivot[I];
+    }
+  }
+  broadcast_boundary(copy_with_offset, system.partitioning, z.boundary, z);
+}
+
+// coarsening stops at this size, the coarsest level is solved directly
+static constexpr int amg_coarsest_rows = 64;
+
+// greedy aggregation over the strong couplings |a_ij| >= theta sqrt(|a_ii a_jj|). Whole neighbourhoods
+// become aggregates first, the remaining cells then join an adjacent aggregate or start a new one
+static std::vector<int> aggregate(const CSRMatrix& A, const std::vector<double>& diagonal, double theta, int& count)
+{
+  const int n = A.rows;
+  auto strong = [&](int i, int k) {
+    int j = A.columns[k];
+    return j != i && std::abs(A.values[k]) >= theta * std::sqrt(std::abs(diagonal[i] * diagonal[j]));
+  };
+  std::vector<int> aggregates(n, -1);
+  count = 0;
+  for (int i = 0; i < n; i++)
+  {
+    bool free = aggregates[i] < 0;
+    bool coupled = false;
+    for (int k = A.row_begin[i]; k < A.row_begin[i + 1] && free; k++)
+    {
+      if (!strong(i, k))
+        continue;
+      coupled = true;
+      free = aggregates[A.columns[k]] < 0;
+    }
+    if (!free || !coupled)
+      continue;
+    aggregates[i] = count;
+    for (int k = A.row_begin[i]; k < A.row_begin[i + 1]; k++)
+    {
+      if (strong(i, k))
+        aggregates[A.columns[k]] = count;
+    }
+    count++;
+  }
+  const std::vector<int> neighbourhoods = aggregates;
+  for (int i = 0; i < n; i++)
+  {
+    for (int k = A.row_begin[i]; k < A.row_begin[i + 1] && aggregates[i] < 0; k++)
+    {
+      if (strong(i, k) && neighbourhoods[A.columns[k]] >= 0)
+        aggregates[i] = neighbourhoods[A.columns[k]];
+    }
+  }
+  for (int i = 0; i < n; i++)
+  {
+    if (aggregates[i] >= 0)
+      continue;
+    aggregates[i] = count;
+    for (int k = A.row_begin[i]; k < A.row_begin[i + 1]; k++)
+    {
+      if (strong(i, k) && aggregates[A.columns[k]] < 0)
+        aggregates[A.columns[k]] = count;
+    }
+    count++;
+  }
+  return aggregates;
+}
+
+AMGPreconditioner::AMGPreconditioner(PDESystem& system)
+{
+  ProfileScope("AMG Setup");
+  // the coarse operators are denser with weaker couplings, so the threshold halves on every level
+  double theta = Settings::get().amgStrength;
+  levels.emplace_back();
+  levels.back().A = SparseMatrixOperator(system.p, system.h, system.partitioning).local_block();
+  while (true)
+  {
+    AMGLevel& level = levels.back();
+    const CSRMatrix& A = level.A;
+    const int n = A.rows;
+    std::vector<double> diagonal(n, 0.);
+    for (int i = 0; i < n; i++)
+    {
+      for (int k = A.row_begin[i]; k < A.row_begin[i + 1]; k++)
+      {
+        if (A.columns[k] == i)
+          diagonal[i] = A.values[k];
+      }
+    }
+    level.inverse_diagonal.resize(n);
+    for (int i = 0; i < n; i++)
+      level.inverse_diagonal[i] = 1. / diagonal[i];
+    level.x.resize(n);
+    level.b.resize(n);
+    level.residual.resize(n);
+    if (n <= amg_coarsest_rows)
+      break;
+    int count;
+    std::vector<int> aggregates = aggregate(A, diagonal, theta, count);
+    if (count == n)
+      break;
+
+    // the tentative prolongation reproduces the constant, the null space of the neumann operator
+    CSRMatrix tentative;
+    tentative.rows = n;
+    tentative.cols = count;
+    tentative.columns = aggregates;
+    tentative.values.assign(n, 1.);
+    tentative.row_begin.resize(n + 1);
+    for (int i = 0; i <= n; i++)
+      tentative.row_begin[i] = i;
+    // one damped jacobi step smooths the basis functions, omega = 4 / (3 rho(D^-1 A))
+    // with the spectral radius bounded by the gershgorin discs
+    double rho = 0.;
+    for (int i = 0; i < n; i++)
+    {
+      double row_sum = 0.;
+      for (int k = A.row_begin[i]; k < A.row_begin[i + 1]; k++)
+        row_sum += std::abs(A.values[k]);
+      rho = std::max(rho, row_sum * std::abs(level.inverse_diagonal[i]));
+    }
+    double omega = 4. / (3. * rho);
+    CSRMatrix smoother = A;
+    for (int i = 0; i < n; i++)
+    {
+      for (int k = A.row_begin[i]; k < A.row_begin[i + 1]; k++)
+      {
+        smoother.values[k] *= -omega * level.inverse_diagonal[i];
+        if (A.columns[k] == i)
+          smoother.values[k] += 1.;
+      }
+    }
+    level.P = multiply(smoother, tentative);
+    level.R = transpose(level.P);
+    CSRMatrix coarse = multiply(level.R, multiply(A, level.P));
+    levels.emplace_back();
+    levels.back().A = std::move(coarse);
+    theta /= 2.;
+  }
+
+  const CSRMatrix& A = levels.back().A;
+  const int n = A.rows;
+  coarsest.assign(n * n, 0.);
+  for (int i = 0; i < n; i++)
+  {
+    for (int k = A.row_begin[i]; k < A.row_begin[i + 1]; k++)
+      coarsest[i * n + A.columns[k]] += A.values[k];
+  }
+  // without interfaces the block is the singular neumann operator, the rank one term fixes the mean
+  if (system.partitioning.size == 1)
+  {
+    double diagonal = 0.;
+    for (int i = 0; i < n; i++)
+      diagonal += coarsest[i * n + i] / n;
+    for (int k = 0; k < n * n; k++)
+      coarsest[k] += diagonal / n;
+  }
+  pivots.resize(n);
+  lu_factor(coarsest, pivots, n);
+}
+
+// gauss seidel on A x = b, backward reverses the order of the rows
+static void gauss_seidel(AMGLevel& level, bool backward)
+{
+  const CSRMatrix& A = level.A;
+  for (int n = 0; n < A.rows; n++)
+  {
+    int i = backward ? A.rows - 1 - n : n;
+    double sum = level.b[i];
+    for (int k = A.row_begin[i]; k < A.row_begin[i + 1]; k++)
+    {
+      if (A.columns[k] != i)
+        sum -= A.values[k] * level.x[A.columns[k]];
+    }
+    level.x[i] = sum * level.inverse_diagonal[i];
+  }
+}
+
+// V-cycle from zero with forward sweeps before and backward sweeps after the coarse grid correction
+static void amg_cycle(AMGPreconditioner& M, size_t l)
+{
+  AMGLevel& level = M.levels[l];
+  if (l + 1 == M.levels.size())
+  {
+    level.x = level.b;
+    lu_solve(M.coarsest, M.pivots, level.A.rows, level.x.data());
+    return;
+  }
+  AMGLevel& coarse = M.levels[l + 1];
+  std::fill(level.x.begin(), level.x.end(), 0.);
+  for (int i = 0; i < Settings::get().multigridPreSmoothing; i++)
+    gauss_seidel(level, false);
+  multiply(level.A, level.x.data(), level.residual.data());
+  for (int i = 0; i < level.A.rows; i++)
+    level.residual[i] = level.b[i] - level.residual[i];
+  multiply(level.R, level.residual.data(), coarse.b.data());
+  amg_cycle(M, l + 1);
+  multiply(level.P, coarse.x.data(), level.residual.data());
+  for (int i = 0; i < level.A.rows; i++)
+    level.x[i] += level.residual[i];
+  for (int i = 0; i < Settings::get().multigridPostSmoothing; i++)
+    gauss_seidel(level, true);
+}
+
+void precondition(AMGPreconditioner& M, PDESystem& system, const Grid2D& r, Grid2D& z)
+{
+  AMGLevel& fine = M.levels.front();
+  const Range range = z.range;
+  int n = 0;
+  for (uint16_t j = range.begin.y; j <= range.end.y; j++)
+    for (uint16_t i = range.begin.x; i <= range.end.x; i++)
+      fine.b[n++] = r[{ i, j }];
+  amg_cycle(M, 0);
+  parallel_broadcast(set, Range { z.begin - II, z.end + II }, Offset { 0, 0 }, z, 0.);
+  n = 0;
+  for (uint16_t j = range.begin.y; j <= range.end.y; j++)
+    for (uint16_t i = range.begin.x; i <= range.end.x; i++)
+      z[{ i, j }] = fine.x[n++];
+  broadcast_boundary(copy_with_offset, system.partitioning, z.boundary, z);
+}
+
+void precondition(ChebyshevPreconditioner& M, PDESystem& system, const Grid2D& r, Grid2D& z)
+{
+  parallel_broadcast(set, Range { z.begin - II, z.end + II }, Offset { 0, 0 }, z, 0.);
+  ResidualSystem residual_system = { z, r, system.h, system.partitioning };
+  chebyshev(residual_system, M.chebyshev, Settings::get().chebyshevDegree, [](int, ChebyshevSolver&) { return false; });
+}
+
+void solve(ChebyshevSolver& S, PDESystem& system)
+{
+  LaplaceMatrixOperator A = LaplaceMatrixOperator(system.h);
+  // the iteration itself needs no reductions, the residual checks are lagged
+  S.monitor.start();
+  chebyshev(system, S, Settings::get().maximumNumberOfIterations, [&](int iter, ChebyshevSolver& S) {
+    double local_residual = S.monitor.due(iter) ? maximum(absolute, S.residual.range, S.residual) / std::abs(A.a_ij) : 0.;
+    bool converged = S.monitor.converged(iter, local_residual);
+    if (S.monitor.checked(iter) && (S.monitor.residual > 1e5 || std::isnan(S.monitor.residual)))
+    {
+      ErrorF("residual exploded {}", S.monitor.residual);
+      abort();
+    }
+    return converged;
+  });
+  S.monitor.finish();
+}
+
+MultigridPreconditioner::MultigridPreconditioner(PDESystem& system)
+  : mg(system)
+{
+  mg.symmetric = true;
+}
+
+void precondition(MultigridPreconditioner& M, PDESystem& system, const Grid2D& r, Grid2D& z)
+{
+  // the cycle starts from zero, ghosts included
+  parallel_broadcast(set, Range { z.begin - II, z.end + II }, Offset { 0, 0 }, z, 0.);
+  ResidualSystem residual_system = { z, r, system.h, system.partitioning };
+  cycle(M.mg, residual_system, M.mg.smoother, M.mg.defect, M.mg.parity, 0, Settings::VCycle);
+}
+
+// offset_x, offset_y, cells_x, cells_y of the pressure block of every rank in the global grid
+static std::vector<std::array<int, 4>> global_blocks(const Partitioning::MPIInfo& info)
+{
+  int size = info.size;
+  Index pos = info.getGridPos();
+  std::array<int, 4> local = { pos.x, pos.y, info.nCells[0], info.nCells[1] };
+  std::vector<std::array<int, 4>> layout(size);
+  MPI_Allgather(local.data(), 4, MPI_INT, layout.data(), 4, MPI_INT, Partitioning::getCommunicator());
+  std::vector<std::array<int, 4>> blocks(size);
+  for (int r = 0; r < size; r++)
+  {
+    // x offset from the ranks to the left, y offset from the ranks below (grid row 0 is the top)
+    int offset_x = 0;
+    int offset_y = 0;
+    for (int q = 0; q < size; q++)
+    {
+      if (layout[q][1] == layout[r][1] && layout[q][0] < layout[r][0])
+        offset_x += layout[q][2];
+      if (layout[q][0] == layout[r][0] && layout[q][1] > layout[r][1])
+        offset_y += layout[q][3];
+    }
+    blocks[r] = { offset_x, offset_y, layout[r][2], layout[r][3] };
+  }
+  return blocks;
+}
+
+FFTSolver::FFTSolver(PDESystem& system)
+  : global_cells { system.settings.nCells[0], system.settings.nCells[1] }
+  , blocks(global_blocks(system.partitioning))
+  , rows(system.partitioning.size)
+  , cols(system.partitioning.size)
+  , eigenvalues_x(global_cells[0])
+  , eigenvalues_y(global_cells[1])
+  , dct_x(global_cells[0])
+  , dct_y(global_cells[1])
+{
+  const auto& info = system.partitioning;
+  int size = info.size;
+  for (int r = 0; r < size; r++)
+  {
+    rows[r] = { r * global_cells[1] / size, (r + 1) * global_cells[1] / size };
+    cols[r] = { r * global_cells[0] / size, (r + 1) * global_cells[0] / size };
+  }
+  int rank = info.rank;
+  row_slab.resize((rows[rank][1] - rows[rank][0]) * global_cells[0]);
+  col_slab.resize((cols[rank][1] - cols[rank][0]) * global_cells[1]);
+  size_t buffer_size = std::max({ row_slab.size(), col_slab.size(), static_cast<size_t>(info.nCells[0] * info.nCells[1]) });
+  send_buffer.resize(buffer_size);
+  recv_buffer.resize(buffer_size);
+
+  for (int k = 0; k < global_cells[0]; k++)
+  {
+    double s = std::sin(std::numbers::pi * k / (2. * global_cells[0]));
+    eigenvalues_x[k] = -4. / system.h.x_squared * s * s;
+  }
+  for (int k = 0; k < global_cells[1]; k++)
+  {
+    double s = std::sin(std::numbers::pi * k / (2. * global_cells[1]));
+    eigenvalues_y[k] = -4. / system.h.y_squared * s * s;
+  }
+}
+
+// pack(q, buffer) and unpack(r, buffer) have to walk the cells of every rank pair in the same order
+template <typename Pack, typename Unpack>
+static void redistribute(FFTSolver& S, Pack&& pack, Unpack&& unpack)
+{
+  ProfileScope("FFT Transpose");
+  int size = S.blocks.size();
+  std::vector<int> send_counts(size);
+  std::vector<int> send_displs(size);
+  std::vector<int> recv_counts(size);
+  std::vector<int> recv_displs(size);
+  int offset = 0;
+  for (int q = 0; q < size; q++)
+  {
+    send_displs[q] = offset;
+    send_counts[q] = pack(q, S.send_buffer.data() + offset);
+    offset += send_counts[q];
+  }
+  MPI_Alltoall(send_counts.data(), 1, MPI_INT, recv_counts.data(), 1, MPI_INT, Partitioning::getCommunicator());
+  offset = 0;
+  for (int r = 0; r < size; r++)
+  {
+    recv_displs[r] = offset;
+    offset += recv_counts[r];
+  }
+  MPI_Alltoallv(S.send_buffer.data(), send_counts.data(), send_displs.data(), MPI_DOUBLE, S.recv_buffer.data(), recv_counts.data(), recv_displs.data(), MPI_DOUBLE, Partitioning::getCommunicator());
+  for (int r = 0; r < size; r++)
+  {
+    unpack(r, S.recv_buffer.data() + recv_displs[r]);
+  }
+}
+
+void solve(FFTSolver& S, PDESystem& system)
+{
+  ProfileScope("FFT Solve");
+  int rank = system.partitioning.rank;
+  const int nx = S.global_cells[0];
+  const int ny = S.global_cells[1];
+  const auto [ox, oy, bx, by] = S.blocks[rank];
+  const auto [row_begin, row_end] = S.rows[rank];
+  const auto [col_begin, col_end] = S.cols[rank];
+  auto local = [&](int x, int y) { return Index { static_cast<uint16_t>(system.p.begin.x + x - ox), static_cast<uint16_t>(system.p.begin.y + y - oy) }; };
+
+  // pressure blocks -> row slabs
+  redistribute(
+    S,
+    [&](int q, double* buffer) {
+      int n = 0;
+      for (int y = std::max(oy, S.rows[q][0]); y < std::min(oy + by, S.rows[q][1]); y++)
+        for (int x = ox; x < ox + bx; x++)
+          buffer[n++] = system.rhs[local(x, y)];
+      return n;
+    },
+    [&](int r, const double* buffer) {
+      const auto [rx, ry, rbx, rby] = S.blocks[r];
+      int n = 0;
+      for (int y = std::max(ry, row_begin); y < std::min(ry + rby, row_end); y++)
+        for (int x = rx; x < rx + rbx; x++)
+          S.row_slab[(y - row_begin) * nx + x] = buffer[n++];
+    });
+  for (int y = row_begin; y < row_end; y++)
+  {
+    S.dct_x.forward(&S.row_slab[(y - row_begin) * nx]);
+  }
+
+  // row slabs -> column slabs
+  redistribute(
+    S,
+    [&](int q, double* buffer) {
+      int n = 0;
+      for (int y = row_begin; y < row_end; y++)
+        for (int x = S.cols[q][0]; x < S.cols[q][1]; x++)
+          buffer[n++] = S.row_slab[(y - row_begin) * nx + x];
+      return n;
+    },
+    [&](int r, const double* buffer) {
+      int n = 0;
+      for (int y = S.rows[r][0]; y < S.rows[r][1]; y++)
+        for (int x = col_begin; x < col_end; x++)
+          S.col_slab[(x - col_begin) * ny + y] = buffer[n++];
+    });
+  for (int x = col_begin; x < col_end; x++)
+  {
+    double* column = &S.col_slab[(x - col_begin) * ny];
+    S.dct_y.forward(column);
+    for (int k = 0; k < ny; k++)
+    {
+      double eigenvalue = S.eigenvalues_x[x] + S.eigenvalues_y[k];
+      // the constant mode is the null space of the Neumann problem, pick the zero mean solution
+      column[k] = (eigenvalue == 0.) ? 0. : column[k] / eigenvalue;
+    }
+    S.dct_y.inverse(column);
+  }
+
+  // column slabs -> row slabs
+  redistribute(
+    S,
+    [&](int q, double* buffer) {
+      int n = 0;
+      for (int y = S.rows[q][0]; y < S.rows[q][1]; y++)
+        for (int x = col_begin; x < col_end; x++)
+          buffer[n++] = S.col_slab[(x - col_begin) * ny + y];
+      return n;
+    },
+    [&](int r, const double* buffer) {
+      int n = 0;
+      for (int y = row_begin; y < row_end; y++)
+        for (int x = S.cols[r][0]; x < S.cols[r][1]; x++)
+          S.row_slab[(y - row_begin) * nx + x] = buffer[n++];
+    });
+  for (int y = row_begin; y < row_end; y++)
+  {
+    S.dct_x.inverse(&S.row_slab[(y - row_begin) * nx]);
+  }
+
+  // row slabs -> pressure blocks
+  redistribute(
+    S,
+    [&](int q, double* buffer) {
+      const auto [qx, qy, qbx, qby] = S.blocks[q];
+      int n = 0;
+      for (int y = std::max(qy, row_begin); y < std::min(qy + qby, row_end); y++)
+        for (int x = qx; x < qx + qbx; x++)
+          buffer[n++] = S.row_slab[(y - row_begin) * nx + x];
+      return n;
+    },
+    [&](int r, const double* buffer) {
+      int n = 0;
+      for (int y = std::max(oy, S.rows[r][0]); y < std::min(oy + by, S.rows[r][1]); y++)
+        for (int x = ox; x < ox + bx; x++)
+          system.p[local(x, y)] = buffer[n++];
+    });
+
+  broadcast_boundary(copy_with_offset, system.partitioning, system.p.boundary, system.p);
+  MPI_COMM_BUFFER* comm = new MPI_COMM_BUFFER(system.p, system.p.boundary.all, Partitioning::getCommunicator(), system.partitioning);
+  delete comm;
+}
+
+// row k of the band, row(k)[j] = L(k, j) for k - bandwidth <= j <= k
+static double* band_row(std::vector<double>& factor, int bandwidth, int k) { return factor.data() + (k + 1) * bandwidth; }
+
+static std::filesystem::path cholesky_cache_file(const std::filesystem::path& directory, const CholeskySolver& S, const Gridsize& h)
+{
+  // hexadecimal spacings keep the key exact
+  std::stringstream name;
+  name << "cholesky_" << S.global_cells[0] << "x" << S.global_cells[1] << "_" << std::hexfloat << h.x << "_" << h.y << ".bin";
+  return directory / name.str();
+}
+
+static bool read_factor(CholeskySolver& S, const Gridsize& h, const std::filesystem::path& file)
+{
+  double header[4];
+  // a truncated file must not leave a partial factor behind, the assembly only writes the stencil entries
+  std::error_code error;
+  if (std::filesystem::file_size(file, error) != sizeof(header) + S.factor.size() * sizeof(double) || error)
+    return false;
+  std::ifstream in(file, std::ios::binary);
+  if (!in.read(reinterpret_cast<char*>(header), sizeof(header)))
+    return false;
+  if (header[0] != S.global_cells[0] || header[1] != S.global_cells[1] || header[2] != h.x || header[3] != h.y)
+    return false;
+  std::vector<double> factor(S.factor.size());
+  if (!in.read(reinterpret_cast<char*>(factor.data()), factor.size() * sizeof(double)))
+    return false;
+  S.factor = std::move(factor);
+  return true;
+}
+
+static void write_factor(const CholeskySolver& S, const Gridsize& h, const std::filesystem::path& file)
+{
+  std::error_code error;
+  std::filesystem::create_directories(file.parent_path(), error);
+  // concurrent runs of a parameter sweep only ever see complete files
+  std::filesystem::path partial = file;
+  partial += ".";
+  partial += std::to_string(getpid());
+  std::ofstream out(partial, std::ios::binary);
+  double header[4] = { static_cast<double>(S.global_cells[0]), static_cast<double>(S.global_cells[1]), h.x, h.y };
+  out.write(reinterpret_cast<const char*>(header), sizeof(header));
+  out.write(reinterpret_cast<const char*>(S.factor.data()), S.factor.size() * sizeof(double));
+  out.close();
+  if (out)
+    std::filesystem::rename(partial, file, error);
+  if (!out || error)
+  {
+    WarningF("could not write the cholesky factor to {}", file.string());
+    std::filesystem::remove(partial, error);
+  }
+}
+
+// in place L L^T of the lower band of the matrix, the fill in stays inside the band
+static void band_cholesky(CholeskySolver& S)
+{
+  ProfileScope("Cholesky Factorization");
+  const int b = S.bandwidth;
+  const int n = S.global_cells[0] * S.global_cells[1];
+  for (int k = 0; k < n; k++)
+  {
+    double* row_k = band_row(S.factor, b, k);
+    int first = std::max(0, k - b);
+    for (int j = first; j <= k; j++)
+    {
+      double* row_j = band_row(S.factor, b, j);
+      double sum = row_k[j];
+#pragma omp simd reduction(+ : sum)
+      for (int i = first; i < j; i++)
+        sum -= row_k[i] * row_j[i];
+      if (j < k)
+        row_k[j] = sum / row_j[j];
+      else if (sum > 0.)
+        row_k[k] = std::sqrt(sum);
+      else
+      {
+        ErrorF("cholesky factorization broke down at row {}", k);
+        abort();
+      }
+    }
+  }
+}
+
+CholeskySolver::CholeskySolver(PDESystem& system)
+  : global_cells { system.settings.nCells[0], system.settings.nCells[1] }
+  , blocks(global_blocks(system.partitioning))
+  , transposed(global_cells[0] > global_cells[1])
+  , bandwidth(std::min(global_cells[0], global_cells[1]))
+  , counts(system.partitioning.size)
+  , displs(system.partitioning.size)
+{
+  const auto& info = system.partitioning;
+  int offset = 0;
+  for (int r = 0; r < info.size; r++)
+  {
+    counts[r] = blocks[r][2] * blocks[r][3];
+    displs[r] = offset;
+    offset += counts[r];
+  }
+  if (info.rank != 0)
+  {
+    buffer.resize(counts[info.rank]);
+    return;
+  }
+  const int n = global_cells[0] * global_cells[1];
+  buffer.resize(n);
+  solution.resize(n);
+  factor.assign(static_cast<size_t>(n) * (bandwidth + 1), 0.);
+  std::filesystem::path cache;
+  if (!system.settings.choleskyCache.empty())
+  {
+    cache = cholesky_cache_file(system.settings.choleskyCache, *this, system.h);
+    if (read_factor(*this, system.h, cache))
+      return;
+  }
+
+  // lower band of the negative laplacian, the Neumann ghosts cancel the coupling across the boundary
+  const int b = bandwidth;
+  const double fast = 1. / (transposed ? system.h.y_squared : system.h.x_squared);
+  const double slow = 1. / (transposed ? system.h.x_squared : system.h.y_squared);
+  for (int k = 0; k < n; k++)
+  {
+    double* row = band_row(factor, b, k);
+    int i = k % b;
+    int j = k / b;
+    double diagonal = 0.;
+    if (i > 0)
+    {
+      row[k - 1] = -fast;
+      diagonal += fast;
+    }
+    if (i < b - 1)
+      diagonal += fast;
+    if (j > 0)
+    {
+      row[k - b] = -slow;
+      diagonal += slow;
+    }
+    if (j < n / b - 1)
+      diagonal += slow;
+    row[k] = diagonal;
+  }
+  // the first unknown is pinned to zero, which removes the constant null space and keeps the matrix SPD
+  band_row(factor, b, 0)[0] = 1.;
+  if (n > 1)
+    band_row(factor, b, 1)[0] = 0.;
+  if (b < n)
+    band_row(factor, b, b)[0] = 0.;
+  band_cholesky(*this);
+  if (!cache.empty())
+    write_factor(*this, system.h, cache);
+}
+
+// x = (L L^T)^-1 x
+static void band_substitution(CholeskySolver& S, std::vector<double>& x)
+{
+  const int b = S.bandwidth;
+  const int n = x.size();
+  for (int k = 0; k < n; k++)
+  {
+    const double* row = band_row(S.factor, b, k);
+    double sum = x[k];
+#pragma omp simd reduction(+ : sum)
+    for (int i = std::max(0, k - b); i < k; i++)
+      sum -= row[i] * x[i];
+    x[k] = sum / row[k];
+  }
+  for (int k = n - 1; k >= 0; k--)
+  {
+    const double* row = band_row(S.factor, b, k);
+    x[k] /= row[k];
+    for (int i = std::max(0, k - b); i < k; i++)
+      x[i] -= row[i] * x[k];
+  }
+}
+
+void solve(CholeskySolver& S, PDESystem& system)
+{
+  ProfileScope("Cholesky Solve");
+  int rank = system.partitioning.rank;
+  const auto [ox, oy, bx, by] = S.blocks[rank];
+  auto local = [&](int x, int y) { return Index { static_cast<uint16_t>(system.p.begin.x + x - ox), static_cast<uint16_t>(system.p.begin.y + y - oy) }; };
+  auto global = [&](int x, int y) { return S.transposed ? y + S.global_cells[1] * x : x + S.global_cells[0] * y; };
+
+  // the block of rank 0 is already in place for the gather
+  int n = 0;
+  for (int y = oy; y < oy + by; y++)
+    for (int x = ox; x < ox + bx; x++)
+      S.buffer[n++] = system.rhs[local(x, y)];
+  if (rank == 0)
+    MPI_Gatherv(MPI_IN_PLACE, 0, MPI_DOUBLE, S.buffer.data(), S.counts.data(), S.displs.data(), MPI_DOUBLE, 0, Partitioning::getCommunicator());
+  else
+    MPI_Gatherv(S.buffer.data(), n, MPI_DOUBLE, nullptr, nullptr, nullptr, MPI_DOUBLE, 0, Partitioning::getCommunicator());
+
+  if (rank == 0)
+  {
+    auto for_each_cell = [&](auto&& f) {
+      for (size_t r = 0; r < S.blocks.size(); r++)
+      {
+        const auto [rx, ry, rbx, rby] = S.blocks[r];
+        int m = S.displs[r];
+        for (int y = ry; y < ry + rby; y++)
+          for (int x = rx; x < rx + rbx; x++)
+            f(S.buffer[m++], S.solution[global(x, y)]);
+      }
+    };
+    for_each_cell([](double rhs, double& b) { b = -rhs; });
+    // the rhs is projected onto the range of the singular matrix, so the pinned equation holds as well
+    double mean = std::accumulate(S.solution.begin(), S.solution.end(), 0.) / S.solution.size();
+    for (double& b : S.solution)
+      b -= mean;
+    S.solution[0] = 0.;
+    band_substitution(S, S.solution);
+    // zero mean solution, as the FFT solver
+    mean = std::accumulate(S.solution.begin(), S.solution.end(), 0.) / S.solution.size();
+    for (double& x : S.solution)
+      x -= mean;
+    for_each_cell([](double& p, double x) { p = x; });
+  }
+
+  if (rank == 0)
+    MPI_Scatterv(S.buffer.data(), S.counts.data(), S.displs.data(), MPI_DOUBLE, MPI_IN_PLACE, 0, MPI_DOUBLE, 0, Partitioning::getCommunicator());
+  else
+    MPI_Scatterv(nullptr, nullptr, nullptr, MPI_DOUBLE, S.buffer.data(), n, MPI_DOUBLE, 0, Partitioning::getCommunicator());
+  n = 0;
+  for (int y = oy; y < oy + by; y++)
+    for (int x = ox; x < ox + bx; x++)
+      system.p[local(x, y)] = S.buffer[n++];
+
+  broadcast_boundary(copy_with_offset, system.partitioning, system.p.boundary, system.p);
+  MPI_COMM_BUFFER* comm = new MPI_COMM_BUFFER(system.p, system.p.boundary.all, Partitioning::getCommunicator(), system.partitioning);
+  delete comm;
+}
+
+// result = A*x, the inner cells are computed while the halo of x is exchanged
+static void apply_overlapped(Grid2D& result, const LaplaceMatrixOperator& A, Grid2D& x, Partitioning::MPIInfo& partitioning)
+{
+  broadcast_boundary(copy_with_offset, partitioning, x.boundary, x);
+  stencil_broadcast(Ax, partitioning, x.range, x, result, A, x);
+}
+
+void solve(PipelinedCGSolver& cg, PDESystem& system)
+{
+  LaplaceMatrixOperator A = LaplaceMatrixOperator(system.h);
+  auto apply_preconditioner = [&](const Grid2D& r, Grid2D& z) {
+    ProfileScope("Preconditioner");
+    std::visit([&](auto& M) { precondition(M, system, r, z); }, cg.preconditioner);
+  };
+
+  // r = b - A x, u = M r, w = A u
+  broadcast_boundary(copy_with_offset, system.partitioning, system.p.boundary, system.p);
+  broadcast_rows(aAxpy_row, system.p.range, cg.residual, -1., A, system.p, system.rhs);
+  apply_preconditioner(cg.residual, cg.preconditioned);
+  apply_overlapped(cg.w, A, cg.preconditioned, system.partitioning);
+
+  double gamma_old = 0.;
+  double alpha_old = 0.;
+  for (int iter = 0; iter < Settings::get().maximumNumberOfIterations; iter++)
+  {
+    ProfileScope("Pipelined CG Iteration");
+    // gamma = (r, u), delta = (w, u) and the residual norm are reduced in the background
+    std::array<double, 2> local_sums = { sum(times, system.p.range, cg.residual, cg.preconditioned), sum(times, system.p.range, cg.w, cg.preconditioned) };
+    std::array<double, 2> global_sums = { 0., 0. };
+    double local_residual = maximum(absolute, system.p.range, cg.residual);
+    double global_residual = 0.;
+    std::array<MPI_Request, 2> requests;
+    MPI_Iallreduce(local_sums.data(), global_sums.data(), 2, MPI_DOUBLE, MPI_SUM, Partitioning::getCommunicator(), &requests[0]);
+    MPI_Iallreduce(&local_residual, &global_residual, 1, MPI_DOUBLE, MPI_MAX, Partitioning::getCommunicator(), &requests[1]);
+
+    // m = M w, n = A m
+    apply_preconditioner(cg.w, cg.m);
+    apply_overlapped(cg.n, A, cg.m, system.partitioning);
+
+    ProfilePush("Reduction Wait");
+    MPI_Waitall(2, requests.data(), MPI_STATUSES_IGNORE);
+    ProfilePop();
+
+    // diagonally scaled, same measure as the CG solver
+    double residual = global_residual / std::abs(A.a_ij);
+    if (residual > 1e5 || std::isnan(residual))
+    {
+      ErrorF("residual exploded {}", residual);
+      abort();
+    }
+    if (residual < Settings::get().epsilon)
+      break;
+
+    double gamma = global_sums[0];
+    double delta = global_sums[1];
+    double beta = (iter > 0) ? gamma / gamma_old : 0.;
+    double alpha = (iter > 0) ? gamma / (delta - beta * gamma / alpha_old) : gamma / delta;
+    gamma_old = gamma;
+    alpha_old = alpha;
+
+    parallel_broadcast(pipelined_cg_update, system.p.range, cg, system.p, alpha, beta);
+  }
+  broadcast_boundary(copy_with_offset, system.partitioning, system.p.boundary, system.p);
+  MPI_COMM_BUFFER* comm_buffer = new MPI_COMM_BUFFER(system.p, system.p.boundary.all, Partitioning::getCommunicator(), system.partitioning);
+  delete comm_buffer;
+}
+
+SStepCGSolver::SStepCGSolver(PDESystem& system)
+  : s(std::max(1, Settings::get().sStepLength))
+  , shift { s, s }
+  , interior { system.begin + shift, system.end + shift }
+  , gram((2 * s + 1) * (2 * s + 2) / 2 + 1, 0.)
+  , global_gram(gram.size(), 0.)
+  , x_coefficients(2 * s + 1)
+  , r_coefficients(2 * s + 1)
+  , p_coefficients(2 * s + 1)
+{
+  if (system.partitioning.nCells[0] < s || system.partitioning.nCells[1] < s)
+  {
+    ErrorF("s-step CG needs at least {} cells per rank and direction", s);
+    abort();
+  }
+  // widened grids, the interior is surrounded by s layers of halo
+  Index end = interior.end + shift;
+  P.reserve(s + 1);
+  for (int j = 0; j <= s; j++)
+    P.emplace_back(system.begin, end);
+  R.reserve(s);
+  for (int j = 0; j < s; j++)
+    R.emplace_back(system.begin, end);
+  wide_halos(interior, s, x_halo, y_halo);
+
+  MPI_Type_contiguous(gram.size(), MPI_DOUBLE, &gram_type);
+  MPI_Type_commit(&gram_type);
+}
+
+// sums the gram matrix entries and takes the maximum of the trailing residual entry
+static void gram_sum_max(void* in, void* inout, int* len, MPI_Datatype* type)
+{
+  int size = 0;
+  MPI_Type_size(*type, &size);
+  size_t n = size / sizeof(double);
+  double* a = static_cast<double*>(in);
+  double* b = static_cast<double*>(inout);
+  for (int k = 0; k < *len; k++, a += n, b += n)
+  {
+    for (size_t i = 0; i + 1 < n; i++)
+      b[i] += a[i];
+    b[n - 1] = std::max(a[n - 1], b[n - 1]);
+  }
+}
+
+// the basis vector j is valid in the interior extended by s - j cells towards every neighbour
+static Range powers_range(const SStepCGSolver& cg, const Partitioning::MPIInfo& partitioning, int j)
+{
+  return extended_range(cg.interior, partitioning, cg.s - j);
+}
+
+static void matrix_powers(SStepCGSolver& cg, const LaplaceMatrixOperator& A, double scale, Partitioning::MPIInfo& partitioning)
+{
+  ProfileScope("Matrix Powers");
+  for (auto& halo : { cg.x_halo, cg.y_halo })
+  {
+    MPI_COMM_BUFFER* p_buffer = new MPI_COMM_BUFFER(cg.P[0], halo, Partitioning::getCommunicator(), partitioning, 0);
+    MPI_COMM_BUFFER* r_buffer = new MPI_COMM_BUFFER(cg.R[0], halo, Partitioning::getCommunicator(), partitioning, 4);
+    delete p_buffer;
+    delete r_buffer;
+  }
+  Range r = powers_range(cg, partitioning, 0);
+  broadcast_boundary(copy_with_offset, partitioning, Boundaries(r.begin, r.end), cg.P[0]);
+  broadcast_boundary(copy_with_offset, partitioning, Boundaries(r.begin, r.end), cg.R[0]);
+  for (int j = 1; j <= cg.s; j++)
+  {
+    r = powers_range(cg, partitioning, j);
+    if (j == 1)
+      parallel_broadcast(chebyshev_first, r, cg.P[j], cg.P[j - 1], A, scale);
+    else
+      parallel_broadcast(chebyshev_next, r, cg.P[j], cg.P[j - 1], cg.P[j - 2], A, scale);
+    broadcast_boundary(copy_with_offset, partitioning, Boundaries(r.begin, r.end), cg.P[j]);
+    if (j == cg.s)
+      break;
+    if (j == 1)
+      parallel_broadcast(chebyshev_first, r, cg.R[j], cg.R[j - 1], A, scale);
+    else
+      parallel_broadcast(chebyshev_next, r, cg.R[j], cg.R[j - 1], cg.R[j - 2], A, scale);
+    broadcast_boundary(copy_with_offset, partitioning, Boundaries(r.begin, r.end), cg.R[j]);
+  }
+}
+
+static void sstep_initial_residual(Index I, SStepCGSolver& cg, const LaplaceMatrixOperator& A, PDESystem& system)
+{
+  Index J = I + cg.shift;
+  cg.R[0][J] = system.rhs[I] - A(system.p, I);
+  cg.P[0][J] = cg.R[0][J];
+  cg.gram.back() = std::max(cg.gram.back(), std::abs(cg.R[0][J]));
+}
+
+void solve(SStepCGSolver& cg, PDESystem& system)
+{
+  static MPI_Op gram_op = [] {
+    MPI_Op op;
+    MPI_Op_create(gram_sum_max, 1, &op);
+    return op;
+  }();
+  LaplaceMatrixOperator A = LaplaceMatrixOperator(system.h);
+  const int s = cg.s;
+  const size_t m = 2 * s + 1;
+  // the spectrum of A lies in [-lambda, 0]
+  const double lambda = 2. * std::abs(A.a_ij);
+  const double scale = 2. / lambda;
+
+  // symmetric gram matrix from its upper triangle
+  std::vector<double> G(m * m);
+  auto gram_dot = [&](const std::vector<double>& a, const std::vector<double>& b) {
+    double result = 0.;
+    for (size_t i = 0; i < m; i++)
+      for (size_t j = 0; j < m; j++)
+        result += a[i] * G[i * m + j] * b[j];
+    return result;
+  };
+  // coefficients of A [P, R] v in the basis [P, R], A T_j = lambda / 2 (Ã T_j - T_j)
+  // the last vector of each block has no successor, its coefficient is zero for every direction of the s iterations
+  auto apply_basis = [&](const std::vector<double>& v) {
+    std::vector<double> result(m, 0.);
+    for (auto [offset, length] : { std::pair<int, int> { 0, s + 1 }, std::pair<int, int> { s + 1, s } })
+    {
+      for (int j = 0; j < length; j++)
+      {
+        double c = lambda / 2. * v[offset + j];
+        result[offset + j] -= c;
+        if (j + 1 < length)
+          result[offset + j + 1] += (j == 0) ? c : c / 2.;
+        if (j > 0)
+          result[offset + j - 1] += c / 2.;
+      }
+    }
+    return result;
+  };
+
+  broadcast_boundary(copy_with_offset, system.partitioning, system.p.boundary, system.p);
+  cg.gram.back() = 0.;
+  broadcast(sstep_initial_residual, system.p.range, cg, A, system);
+
+  for (int iter = 0; iter < Settings::get().maximumNumberOfIterations; iter += s)
+  {
+    ProfileScope("SStep CG Iteration");
+    matrix_powers(cg, A, scale, system.partitioning);
+
+    std::fill(cg.gram.begin(), cg.gram.end() - 1, 0.);
+    broadcast(sstep_gram, cg.interior, cg);
+    ProfilePush("Gram Reduction");
+    MPI_Allreduce(cg.gram.data(), cg.global_gram.data(), 1, cg.gram_type, gram_op, Partitioning::getCommunicator());
+    ProfilePop();
+
+    // the residual maximum belongs to the current iterate, computed while it was assembled
+    double residual = cg.global_gram.back() / std::abs(A.a_ij);
+    if (residual > 1e5 || std::isnan(residual))
+    {
+      ErrorF("residual exploded {}", residual);
+      abort();
+    }
+    if (residual < Settings::get().epsilon)
+      break;
+
+    for (size_t i = 0, k = 0; i < m; i++)
+      for (size_t j = i; j < m; j++, k++)
+        G[i * m + j] = G[j * m + i] = cg.global_gram[k];
+
+    std::fill(cg.x_coefficients.begin(), cg.x_coefficients.end(), 0.);
+    std::fill(cg.r_coefficients.begin(), cg.r_coefficients.end(), 0.);
+    std::fill(cg.p_coefficients.begin(), cg.p_coefficients.end(), 0.);
+    cg.r_coefficients[s + 1] = 1.;
+    cg.p_coefficients[0] = 1.;
+    double residual_norm = gram_dot(cg.r_coefficients, cg.r_coefficients);
+    for (int j = 0; j < s; j++)
+    {
+      std::vector<double> Ap = apply_basis(cg.p_coefficients);
+      double alpha = residual_norm / gram_dot(cg.p_coefficients, Ap);
+      for (size_t i = 0; i < m; i++)
+      {
+        cg.x_coefficients[i] += alpha * cg.p_coefficients[i];
+        cg.r_coefficients[i] -= alpha * Ap[i];
+      }
+      double old_residual_norm = residual_norm;
+      residual_norm = gram_dot(cg.r_coefficients, cg.r_coefficients);
+      double beta = residual_norm / old_residual_norm;
+      for (size_t i = 0; i < m; i++)
+        cg.p_coefficients[i] = cg.r_coefficients[i] + beta * cg.p_coefficients[i];
+    }
+
+    cg.gram.back() = 0.;
+    broadcast(sstep_update, system.p.range, cg, system.p);
+  }
+  broadcast_boundary(copy_with_offset, system.partitioning, system.p.boundary, system.p);
+  MPI_COMM_BUFFER* comm_buffer = new MPI_COMM_BUFFER(system.p, system.p.boundary.all, Partitioning::getCommunicator(), system.partitioning);
+  delete comm_buffer;
+}
+
+void solve_pressure(PDESystem& system)
+{
+  ProfileScope("Pressure Solver");
+  PressureSolverRegistry& registry = *system.solvers;
+  switch (Settings::get().pressureSolver)
+  {
+  case Settings::BlackRed:
+    solve(registry.get<BlackRedSolver>(system), system);
+    break;
+  case Settings::CG:
+    solve(registry.get<CGSolver>(system), system);
+    break;
+  case Settings::SOR:
+    // keeps the learned omega across time steps
+    if (Settings::get().mixedPrecision)
+      solve(registry.get<MixedPrecisionSolver>(system), system);
+    else
+      solve(registry.get<SORSolver>(system), system);
+    break;
+  case Settings::Jacoby:
+    solve(registry.get<Jacoby>(system), system);
+    break;
+  case Settings::GaussSeidel:
+    solve(registry.get<GaussSeidelSolver>(system), system);
+    break;
+  case Settings::Multigrid:
+    solve(registry.get<MultigridSolver>(system), system);
+    break;
+  case Settings::FFT:
+    solve(registry.get<FFTSolver>(system), system);
+    break;
+  case Settings::PipelinedCG:
+    solve(registry.get<PipelinedCGSolver>(system), system);
+    break;
+  case Settings::SStepCG:
+    solve(registry.get<SStepCGSolver>(system), system);
+    break;
+  case Settings::Chebyshev:
+    solve(registry.get<ChebyshevSolver>(system), system);
+    break;
+  case Settings::Zebra:
+    solve(registry.get<ZebraSolver>(system), system);
+    break;
+  case Settings::Cholesky:
+    solve(registry.get<CholeskySolver>(system), system);
+    break;
   }
 }
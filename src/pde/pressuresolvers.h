@@ -2,58 +2,477 @@
 #define PRESSURESOLVERS_H_
 
 #include "grid/grid.h"
+#include "linalg/fft.h"
 #include "linalg/matrix.h"
 #include "linalg/vector.h"
+#include <array>
+#include <optional>
 #include <pde/system.h>
+#include <tuple>
+#include <type_traits>
+#include <utils/convergence.h>
 #include <utils/index.h>
-
-struct CGSolver
-{
-  Grid2D residual;
-  Grid2D search_direction;
-  CGSolver(PDESystem& system)
-    : residual(system.begin, system.end)
-    , search_direction(system.begin, system.end) {
-    };
-};
+#include <utils/profiler.h>
+#include <variant>
+#include <vector>
 
 struct GaussSeidelSolver
 {
   // Grid2D residual;
   // GaussSeidelSolver(PDESystem& system)
   //   : residual(system.begin, system.end) { };
+  ConvergenceMonitor monitor;
+  GaussSeidelSolver()
+    : monitor(Settings::get().epsilon) { };
 };
 
 struct SORSolver
 {
-  // Grid2D residual;
-  // SORSolver(PDESystem& system)
-  //   : residual(system.begin, system.end) { };
+  // relaxation factor, learned from the residual contraction when omega = auto and kept across time steps
+  double omega;
+  bool learned = false;
+  ConvergenceMonitor monitor;
+  SORSolver()
+    : omega(Settings::get().omega)
+    , monitor(Settings::get().epsilon) { };
+};
+
+// widened copies of the pressure system for temporal blocking. The interior is surrounded by a halo
+// of `width` layers, so `depth` iterations run between two halo exchanges on ranges that shrink
+// towards the neighbours. The iterations advance together row by row in a single pass, each one a
+// few rows behind the previous, so the grid is streamed through the cache once per block
+struct TemporalBlocking
+{
+  const int depth;
+  const int width;
+  const Offset shift; // system index -> index in the widened grids
+  const Range interior;
+  Grid2D p;
+  Grid2D tmp; // second buffer of the jacobi iteration
+  Grid2D rhs;
+  Grid2D residual;
+  std::array<std::tuple<Range, Offset>, 4> x_halo;
+  std::array<std::tuple<Range, Offset>, 4> y_halo;
+  TemporalBlocking(PDESystem& system, int depth, int width);
 };
+
 struct BlackRedSolver
 {
   Grid2D residual;
+  ConvergenceMonitor monitor;
+  // every black-red sweep needs two more halo layers
+  std::optional<TemporalBlocking> blocking;
   BlackRedSolver(PDESystem& system)
-    : residual(system.p.begin, system.p.end) { };
+    : residual(system.p.begin, system.p.end)
+    , monitor(Settings::get().epsilon)
+  {
+    if (Settings::get().temporalBlocking > 1)
+      blocking.emplace(system, Settings::get().temporalBlocking, 2 * Settings::get().temporalBlocking);
+  };
+  BlackRedSolver(Index begin, Index end)
+    : residual(begin, end)
+    , monitor(Settings::get().epsilon) { };
 };
 struct Jacoby
 {
   Grid2D residual;
   Grid2D tmp;
+  ConvergenceMonitor monitor;
+  std::optional<TemporalBlocking> blocking;
   Jacoby(PDESystem& system)
     : residual(system.p.begin, system.p.end)
-    , tmp(system.p.begin, system.p.end) { };
+    , tmp(system.p.begin, system.p.end)
+    , monitor(Settings::get().epsilon)
+  {
+    if (Settings::get().temporalBlocking > 1)
+      blocking.emplace(system, Settings::get().temporalBlocking, Settings::get().temporalBlocking);
+  };
+};
+
+// communication avoiding s-step CG, a matrix powers kernel over a halo of width s builds
+// chebyshev bases of the search direction and the residual, s iterations then run on their
+// gram matrix, one halo exchange and one global reduction every s iterations
+struct SStepCGSolver
+{
+  const int s;
+  const Offset shift; // system index -> index in the widened grids
+  const Range interior;
+  std::vector<Grid2D> P; // T_0(A) p ... T_s(A) p
+  std::vector<Grid2D> R; // T_0(A) r ... T_{s-1}(A) r
+  // the halo is exchanged in x first, the y exchange then carries the corners
+  std::array<std::tuple<Range, Offset>, 4> x_halo;
+  std::array<std::tuple<Range, Offset>, 4> y_halo;
+  // upper triangle of the gram matrix of [P, R] followed by the local residual maximum
+  std::vector<double> gram;
+  std::vector<double> global_gram;
+  MPI_Datatype gram_type;
+  // coefficients of the iterates in the basis [P, R]
+  std::vector<double> x_coefficients;
+  std::vector<double> r_coefficients;
+  std::vector<double> p_coefficients;
+  SStepCGSolver(PDESystem& system);
+};
+
+// chebyshev semi iteration for the spectral interval [lower, upper] of A, no inner products
+struct ChebyshevSolver
+{
+  Grid2D residual;
+  Grid2D direction;
+  double lower;
+  double upper;
+  ConvergenceMonitor monitor;
+  ChebyshevSolver(PDESystem& system);
+  ChebyshevSolver(Index begin, Index end, std::pair<double, double> interval)
+    : residual(begin, end)
+    , direction(begin, end)
+    , lower(interval.first)
+    , upper(interval.second)
+    , monitor(Settings::get().epsilon) { };
+};
+
+// thomas algorithm for the lines of one grid direction. All lines share the matrix, so it is
+// factored once. A line that crosses subdomains is split into one segment per rank, the segments
+// are coupled through a reduced system for their end points (partition method), which every rank
+// of the line solves after an allgather of the end points
+struct LineSolver
+{
+  Offset along;
+  Offset across;
+  int length; // cells of the local segment
+  int lines;
+  double coupling; // 1 / h^2 along the line
+  double cross; // 1 / h^2 across the line
+  int parity; // global colour of the first local line
+  // forward elimination factors and inverse pivots of the segment matrix
+  std::vector<double> elimination;
+  std::vector<double> inverse_pivot;
+  // response of the segment to unit values at the last cell of the previous and the first cell
+  // of the next segment
+  std::vector<double> left;
+  std::vector<double> right;
+  // ranks along the line, ordered by their grid position
+  MPI_Comm comm;
+  int position;
+  int ranks;
+  // LU factors of the reduced system, first and last cell of every segment
+  std::vector<double> reduced;
+  std::vector<int> pivots;
+  std::vector<double> ends;
+  std::vector<double> all_ends;
+  std::vector<double> end_values;
+  LineSolver(Offset along, Index begin, Index end, const Gridsize& h, const Partitioning::MPIInfo& partitioning, int level);
+};
+
+// zebra line relaxation, every line of one colour is solved exactly with the neighbouring lines
+// fixed, alternating between rows and columns. Converges independently of the aspect ratio of the cells
+struct ZebraSolver
+{
+  LineSolver rows;
+  LineSolver columns;
+  ConvergenceMonitor monitor;
+  ZebraSolver(PDESystem& system);
+  ZebraSolver(Index begin, Index end, const Gridsize& h, const Partitioning::MPIInfo& partitioning, int level);
+};
+
+// workspaces of the smoothers available on a multigrid level
+struct MultigridSmoother
+{
+  BlackRedSolver blackred;
+  // damps the upper three quarters of the spectrum
+  ChebyshevSolver chebyshev;
+  // only created when selected, it splits the communicator on every level
+  std::optional<ZebraSolver> zebra;
+  int parity; // black/red colour of the first local cell on the level
+  MultigridSmoother(Index begin, Index end, const Gridsize& h, const Partitioning::MPIInfo& partitioning, int level, int nx, int ny);
+};
+
+// one coarsened copy of the pressure system, cells are twice as large as on the next finer level
+struct MultigridLevel
+{
+  Grid2D p;
+  Grid2D rhs;
+  Grid2D defect;
+  MultigridSmoother smoother;
+  const Gridsize h;
+  Partitioning::MPIInfo partitioning;
+  double residual = 0;
+  int parity;
+  MultigridLevel(Index end, const Gridsize& h, const Partitioning::MPIInfo& partitioning, int parity, int level, int nx, int ny)
+    : p(Index { 2, 2 }, end)
+    , rhs(Index { 2, 2 }, end)
+    , defect(Index { 2, 2 }, end)
+    , smoother(Index { 2, 2 }, end, h, partitioning, level, nx, ny)
+    , h(h)
+    , partitioning(partitioning)
+    , parity(parity) { };
+};
+
+struct MultigridSolver
+{
+  Grid2D defect;
+  MultigridSmoother smoother;
+  int parity;
+  // adjoint restriction and reversed post smoothing, required when used as a CG preconditioner
+  bool symmetric = false;
+  // levels[0] is the first level below the pressure grid of the PDESystem
+  std::vector<MultigridLevel> levels;
+  MultigridSolver(PDESystem& system);
+};
+
+// pressure system living in the grids of someone else, used to run cycles on a residual equation
+template <typename T>
+struct BasicResidualSystem
+{
+  BasicGrid2D<T>& p;
+  const BasicGrid2D<T>& rhs;
+  const Gridsize& h;
+  Partitioning::MPIInfo& partitioning;
+  double residual = 0;
+};
+using ResidualSystem = BasicResidualSystem<double>;
+
+// SOR on single precision grids with iterative refinement in double precision, the correction
+// equation A e = rhs - A p is solved in float and e is added to the pressure until its residual
+// is below epsilon. Sweeps and halo messages move half the bytes of the double precision SOR.
+struct MixedPrecisionSolver
+{
+  Grid2DFloat correction;
+  Grid2DFloat residual;
+  SORSolver sor;
+  MixedPrecisionSolver(PDESystem& system)
+    : correction(system.p.begin, system.p.end)
+    , residual(system.p.begin, system.p.end) { };
+};
+
+// z = r / a_ij, the diagonal scaling the CG solver used before preconditioners became pluggable
+struct JacobiPreconditioner
+{
+};
+
+// z = one symmetric V-cycle on A z = r starting from zero
+struct MultigridPreconditioner
+{
+  MultigridSolver mg;
+  MultigridPreconditioner(PDESystem& system);
+};
+
+// fixed degree chebyshev polynomial in A over the whole nonzero spectrum
+struct ChebyshevPreconditioner
+{
+  ChebyshevSolver chebyshev;
+  ChebyshevPreconditioner(PDESystem& system)
+    : chebyshev(system) { };
+};
+
+// non overlapping additive schwarz, every rank approximately solves A z = r on its own cells with
+// zero dirichlet data at the subdomain interfaces. The local solve is a fixed number of symmetric
+// red-black SOR sweeps without any communication
+struct BlockJacobiPreconditioner
+{
+};
+
+// symmetric SOR, one red-black sweep from zero followed by one in the reversed colour order,
+// with halo exchanges between the colours like the SOR solver
+struct SSORPreconditioner
+{
+};
+
+// incomplete cholesky factorization without fill in, -A ~ (D + L) D^-1 (D + L^T) with L the lower
+// part of the 5-point stencil. The lexicographic substitutions are sequential, so the factorization
+// is rank local and drops the couplings across the subdomain interfaces
+struct IncompleteCholeskyPreconditioner
+{
+  Grid2D inverse_pivot;
+  IncompleteCholeskyPreconditioner(PDESystem& system);
+};
+
+// one level of the aggregation hierarchy, P prolongates from the next coarser level
+struct AMGLevel
+{
+  CSRMatrix A;
+  CSRMatrix P;
+  CSRMatrix R; // P^T
+  std::vector<double> inverse_diagonal;
+  std::vector<double> x;
+  std::vector<double> b;
+  std::vector<double> residual;
+};
+
+// smoothed aggregation algebraic multigrid on the rank local block of the SparseMatrixOperator,
+// z = one symmetric V-cycle with gauss seidel smoothing. The hierarchy is built from the matrix
+// entries alone, like the block jacobi preconditioner it drops the couplings across the interfaces
+struct AMGPreconditioner
+{
+  std::vector<AMGLevel> levels;
+  // LU factors of the coarsest matrix
+  std::vector<double> coarsest;
+  std::vector<int> pivots;
+  AMGPreconditioner(PDESystem& system);
+};
+
+using Preconditioner = std::variant<JacobiPreconditioner, MultigridPreconditioner, ChebyshevPreconditioner, BlockJacobiPreconditioner,
+  SSORPreconditioner, IncompleteCholeskyPreconditioner, AMGPreconditioner>;
+
+void precondition(JacobiPreconditioner& M, PDESystem& system, const Grid2D& r, Grid2D& z);
+void precondition(MultigridPreconditioner& M, PDESystem& system, const Grid2D& r, Grid2D& z);
+void precondition(ChebyshevPreconditioner& M, PDESystem& system, const Grid2D& r, Grid2D& z);
+void precondition(BlockJacobiPreconditioner& M, PDESystem& system, const Grid2D& r, Grid2D& z);
+void precondition(SSORPreconditioner& M, PDESystem& system, const Grid2D& r, Grid2D& z);
+void precondition(IncompleteCholeskyPreconditioner& M, PDESystem& system, const Grid2D& r, Grid2D& z);
+void precondition(AMGPreconditioner& M, PDESystem& system, const Grid2D& r, Grid2D& z);
+Preconditioner make_preconditioner(PDESystem& system);
+
+// additive coarse space with one constant unknown per rank, z += Z E^-1 Z^T r with the galerkin
+// matrix E = Z^T A Z. The low frequency error crosses all subdomains within one iteration instead
+// of one halo exchange per iteration, so the CG iteration count no longer grows with the ranks
+struct CoarseCorrection
+{
+  // LU factors of E, regularized in the direction of the constant pressure
+  std::vector<double> galerkin;
+  std::vector<int> pivots;
+  std::vector<double> sums; // Z^T r
+  std::vector<double> values; // E^-1 Z^T r
+  CoarseCorrection(PDESystem& system);
+};
+
+// adds the coarse correction to z, returns its contribution to r^T z
+double coarse_correction(CoarseCorrection& C, PDESystem& system, const Grid2D& r, Grid2D& z);
+
+struct CGSolver
+{
+  Grid2D residual;
+  Grid2D search_direction;
+  Grid2D preconditioned;
+  Grid2D applied; // A * search_direction
+  Preconditioner preconditioner;
+  // a single rank has no coarse space besides the constant null space
+  std::optional<CoarseCorrection> coarse;
+  CGSolver(PDESystem& system)
+    : residual(system.begin, system.end)
+    , search_direction(system.begin, system.end)
+    , preconditioned(system.begin, system.end)
+    , applied(system.begin, system.end)
+    , preconditioner(make_preconditioner(system))
+  {
+    if (Settings::get().coarseCorrection && system.partitioning.size > 1)
+      coarse.emplace(system);
+  };
+};
+
+// Ghysels-Vanroose pipelined CG, the global reductions of an iteration are in flight while
+// the preconditioner and the next Laplace application (including its halo exchange) run
+struct PipelinedCGSolver
+{
+  Grid2D residual; // r
+  Grid2D preconditioned; // u = M r
+  Grid2D w; // w = A u
+  Grid2D m; // m = M w
+  Grid2D n; // n = A m
+  Grid2D z;
+  Grid2D q;
+  Grid2D s;
+  Grid2D search_direction; // p
+  Preconditioner preconditioner;
+  PipelinedCGSolver(PDESystem& system)
+    : residual(system.begin, system.end)
+    , preconditioned(system.begin, system.end)
+    , w(system.begin, system.end)
+    , m(system.begin, system.end)
+    , n(system.begin, system.end)
+    , z(system.begin, system.end)
+    , q(system.begin, system.end)
+    , s(system.begin, system.end)
+    , search_direction(system.begin, system.end)
+    , preconditioner(make_preconditioner(system)) { };
+};
+
+// direct solve of the Neumann problem on the uniform box, the 5-point Laplacian is diagonal in the DCT-II basis
+// the block decomposition is transposed into row slabs for the x transform and column slabs for the y transform
+struct FFTSolver
+{
+  int global_cells[2];
+  // offset_x, offset_y, cells_x, cells_y of the pressure block of every rank
+  std::vector<std::array<int, 4>> blocks;
+  // [begin, end) of the global rows and columns owned by every rank in the slab layouts
+  std::vector<std::array<int, 2>> rows;
+  std::vector<std::array<int, 2>> cols;
+  // row slab is row major with global_cells[0] entries per row, column slab column major
+  std::vector<double> row_slab;
+  std::vector<double> col_slab;
+  std::vector<double> send_buffer;
+  std::vector<double> recv_buffer;
+  std::vector<double> eigenvalues_x;
+  std::vector<double> eigenvalues_y;
+  DCT dct_x;
+  DCT dct_y;
+  FFTSolver(PDESystem& system);
+};
+
+// direct solve of the Neumann problem with a banded Cholesky factor L L^T of the negative 5-point Laplacian,
+// factorized once (or read from Settings::choleskyCache) and applied with two band substitutions on rank 0
+struct CholeskySolver
+{
+  int global_cells[2];
+  std::vector<std::array<int, 4>> blocks;
+  // unknowns are numbered along the shorter side first, which is also the bandwidth of L
+  bool transposed;
+  int bandwidth;
+  // row k of L holds L(k, k - bandwidth) ... L(k, k), rank 0 only
+  std::vector<double> factor;
+  std::vector<double> solution;
+  // pressure blocks of all ranks in rank order, gathered on rank 0
+  std::vector<double> buffer;
+  std::vector<int> counts;
+  std::vector<int> displs;
+  CholeskySolver(PDESystem& system);
 };
 
 void solve(GaussSeidelSolver& S, PDESystem& system);
 void solve(SORSolver& S, PDESystem& system);
+void solve(MixedPrecisionSolver& S, PDESystem& system);
 void solve(CGSolver& S, PDESystem& system);
 void solve(BlackRedSolver& S, PDESystem& system);
 void solve(Jacoby& S, PDESystem& system);
+void solve(MultigridSolver& S, PDESystem& system);
+void solve(FFTSolver& S, PDESystem& system);
+void solve(PipelinedCGSolver& S, PDESystem& system);
+void solve(SStepCGSolver& S, PDESystem& system);
+void solve(ChebyshevSolver& S, PDESystem& system);
+void solve(CholeskySolver& S, PDESystem& system);
+
+// workspaces of all pressure solvers, owned by the PDESystem
+// a solver is created on its first use and then reused for the whole run
+struct PressureSolverRegistry
+{
+  std::tuple<std::optional<GaussSeidelSolver>, std::optional<SORSolver>, std::optional<BlackRedSolver>, std::optional<Jacoby>,
+    std::optional<CGSolver>, std::optional<PipelinedCGSolver>, std::optional<SStepCGSolver>, std::optional<ChebyshevSolver>,
+    std::optional<MultigridSolver>, std::optional<FFTSolver>, std::optional<MixedPrecisionSolver>, std::optional<ZebraSolver>,
+    std::optional<CholeskySolver>>
+    solvers;
+
+  template <typename Solver>
+  Solver& get(PDESystem& system)
+  {
+    std::optional<Solver>& solver = std::get<std::optional<Solver>>(solvers);
+    if (!solver)
+    {
+      ProfileScope("Pressure Solver Setup");
+      if constexpr (std::is_constructible_v<Solver, PDESystem&>)
+        solver.emplace(system);
+      else
+        solver.emplace();
+    }
+    return *solver;
+  }
+};
+
+// dispatches Settings::pressureSolver to the matching solver of the registry
+void solve_pressure(PDESystem& system);
 
 inline void copy_with_offset(Index I, Offset O, Grid2D& array) { array[I] = array[I + O]; };
 
-inline std::pair<double, double> jacoby_update(Index I, const PDESystem& system)
+template <typename System>
+inline std::pair<double, double> jacoby_update(Index I, const System& system)
 {
   auto& p = system.p;
   auto& h = system.h;
@@ -65,27 +484,31 @@ inline std::pair<double, double> jacoby_update(Index I, const PDESystem& system)
   return { update, residual };
 }
 
-inline void gauss_seidel_step(Index I, PDESystem& system, GaussSeidelSolver& S)
+// returns the residual before the update, the wavefront sweep reduces it across the threads
+inline double gauss_seidel_step(Index I, PDESystem& system)
 {
   auto& p = system.p;
   auto& h = system.h;
   double sum_of_neighbours = ((p[I - Ix] + p[I + Ix]) / h.x_squared) + ((p[I - Iy] + p[I + Iy]) / h.y_squared);
   double a_ij = -2 * (1 / h.y_squared) - 2 * (1 / h.x_squared);
-  system.residual = std::max(std::abs(sum_of_neighbours + a_ij * p[I] - system.rhs[I]), system.residual);
+  double residual = std::abs(sum_of_neighbours + a_ij * p[I] - system.rhs[I]);
   p[I] = (system.rhs[I] - sum_of_neighbours) / a_ij;
+  return residual;
 };
 
-inline void sor_step(Index I, PDESystem& system)
+template <typename System>
+inline double sor_step(Index I, System& system, double omega)
 {
   auto& p = system.p;
   auto& h = system.h;
   double sum_of_neighbours = ((p[I - Ix] + p[I + Ix]) / h.x_squared) + ((p[I - Iy] + p[I + Iy]) / h.y_squared);
   double a_ij = -2 * (1 / h.y_squared) - 2 * (1 / h.x_squared);
   double residual = std::abs(sum_of_neighbours + a_ij * p[I] - system.rhs[I]);
-  system.residual = std::max(residual, system.residual);
-  p[I] = (1 - Settings::get().omega) * p[I] + Settings::get().omega * (system.rhs[I] - sum_of_neighbours) / a_ij;
+  p[I] = (1 - omega) * p[I] + omega * (system.rhs[I] - sum_of_neighbours) / a_ij;
+  return residual;
 };
-inline void black_red_step(Index I, PDESystem& system, BlackRedSolver& solver)
+template <typename System>
+inline void black_red_step(Index I, System& system, BlackRedSolver& solver)
 {
   auto [up, res] = jacoby_update(I, system);
   // DebugF("Update {} , residual {}", up, res);
@@ -101,4 +524,176 @@ inline void jacoby_step(Index I, const PDESystem& system, Jacoby& solver)
   solver.tmp[I] = up;
 };
 
+// stores A*s for the update pass and accumulates s^T A s
+// A s on a row of n cells starting at I, returns the row's part of s^T A s
+inline Reduction cg_apply_row(Index I, int n, CGSolver& cg, const LaplaceMatrixOperator& A)
+{
+  double* __restrict applied = cg.applied.row(I);
+  const double* __restrict south = cg.search_direction.row(I - Iy);
+  const double* __restrict centre = cg.search_direction.row(I);
+  const double* __restrict north = cg.search_direction.row(I + Iy);
+  double sAs = 0.;
+#pragma omp simd reduction(+ : sAs)
+  for (int k = 0; k < n; k++)
+  {
+    applied[k] = A(south, centre, north, k);
+    sAs += applied[k] * centre[k];
+  }
+  return { sAs, 0. };
+}
+
+// magnitude of rhs - A p for the max reduction
+inline double laplace_residual(Index I, const LaplaceMatrixOperator& A, const Grid2D& p, const Grid2D& rhs)
+{
+  return std::abs(rhs[I] - A(p, I));
+}
+
+// single precision copy of rhs - A p, returns its magnitude for the max reduction
+inline double mixed_residual(Index I, Grid2DFloat& r, const LaplaceMatrixOperator& A, const Grid2D& p, const Grid2D& rhs)
+{
+  double residual = rhs[I] - A(p, I);
+  r[I] = residual;
+  return std::abs(residual);
+}
+
+inline void add_correction(Index I, Grid2D& p, const Grid2DFloat& e)
+{
+  p[I] += e[I];
+}
+
+// p += alpha s, r -= alpha A s and the residual maximum
+inline Reduction cg_update_row(Index I, int n, CGSolver& cg, Grid2D& p, double alpha)
+{
+  double* __restrict x = p.row(I);
+  double* __restrict r = cg.residual.row(I);
+  const double* __restrict s = cg.search_direction.row(I);
+  const double* __restrict As = cg.applied.row(I);
+  double max = 0.;
+#pragma omp simd reduction(max : max)
+  for (int k = 0; k < n; k++)
+  {
+    x[k] += alpha * s[k];
+    r[k] -= alpha * As[k];
+    max = std::max(max, std::abs(r[k]));
+  }
+  return { 0., max };
+}
+
+// cg_update_row with jacobi preconditioning z = r / a_ij and r^T z in the same pass
+inline Reduction cg_update_jacobi_row(Index I, int n, CGSolver& cg, Grid2D& p, double alpha, double inverse_diagonal)
+{
+  double* __restrict x = p.row(I);
+  double* __restrict r = cg.residual.row(I);
+  double* __restrict z = cg.preconditioned.row(I);
+  const double* __restrict s = cg.search_direction.row(I);
+  const double* __restrict As = cg.applied.row(I);
+  double sum = 0.;
+  double max = 0.;
+#pragma omp simd reduction(+ : sum) reduction(max : max)
+  for (int k = 0; k < n; k++)
+  {
+    x[k] += alpha * s[k];
+    r[k] -= alpha * As[k];
+    z[k] = inverse_diagonal * r[k];
+    sum += r[k] * z[k];
+    max = std::max(max, std::abs(r[k]));
+  }
+  return { sum, max };
+}
+
+// T_1 = Ã T_0 with Ã = scale * A + I mapping the spectrum of A onto [-1, 1]
+inline void chebyshev_first(Index I, Grid2D& next, const Grid2D& current, const LaplaceMatrixOperator& A, double scale)
+{
+  next[I] = scale * A(current, I) + current[I];
+}
+
+// T_{j+1} = 2 Ã T_j - T_{j-1}
+inline void chebyshev_next(Index I, Grid2D& next, const Grid2D& current, const Grid2D& previous, const LaplaceMatrixOperator& A, double scale)
+{
+  next[I] = 2. * (scale * A(current, I) + current[I]) - previous[I];
+}
+
+inline void sstep_gram(Index I, SStepCGSolver& cg)
+{
+  size_t k = 0;
+  for (size_t a = 0; a < cg.P.size() + cg.R.size(); a++)
+  {
+    double ya = (a < cg.P.size()) ? cg.P[a][I] : cg.R[a - cg.P.size()][I];
+    for (size_t b = a; b < cg.P.size() + cg.R.size(); b++, k++)
+    {
+      cg.gram[k] += ya * ((b < cg.P.size()) ? cg.P[b][I] : cg.R[b - cg.P.size()][I]);
+    }
+  }
+}
+
+// x += [P, R] x', r = [P, R] r', p = [P, R] p' and the residual maximum
+inline void sstep_update(Index I, SStepCGSolver& cg, Grid2D& x)
+{
+  Index J = I + cg.shift;
+  double dx = 0., r = 0., p = 0.;
+  for (size_t a = 0; a < cg.P.size() + cg.R.size(); a++)
+  {
+    double y = (a < cg.P.size()) ? cg.P[a][J] : cg.R[a - cg.P.size()][J];
+    dx += cg.x_coefficients[a] * y;
+    r += cg.r_coefficients[a] * y;
+    p += cg.p_coefficients[a] * y;
+  }
+  x[I] += dx;
+  cg.R[0][J] = r;
+  cg.P[0][J] = p;
+  cg.gram.back() = std::max(cg.gram.back(), std::abs(r));
+}
+
+// x += d, r -= A d
+inline void chebyshev_step(Index I, Grid2D& x, Grid2D& r, const LaplaceMatrixOperator& A, const Grid2D& d)
+{
+  x[I] += d[I];
+  r[I] -= A(d, I);
+}
+
+// all recurrences of one pipelined CG iteration in a single pass
+inline void pipelined_cg_update(Index I, PipelinedCGSolver& cg, Grid2D& p, double alpha, double beta)
+{
+  cg.z[I] = cg.n[I] + beta * cg.z[I];
+  cg.q[I] = cg.m[I] + beta * cg.q[I];
+  cg.s[I] = cg.w[I] + beta * cg.s[I];
+  cg.search_direction[I] = cg.preconditioned[I] + beta * cg.search_direction[I];
+  p[I] += alpha * cg.search_direction[I];
+  cg.residual[I] -= alpha * cg.s[I];
+  cg.preconditioned[I] -= alpha * cg.q[I];
+  cg.w[I] -= alpha * cg.z[I];
+}
+
+// cell centered full weighting, each coarse cell averages the four fine cells it covers
+inline void restrict_defect(Index I, const Grid2D& fine, Grid2D& coarse)
+{
+  Index F = { static_cast<uint16_t>(2 * I.x - 2), static_cast<uint16_t>(2 * I.y - 2) };
+  coarse[I] = 0.25 * (fine[F] + fine[F + Ix] + fine[F + Iy] + fine[F + II]);
+}
+
+// adjoint of the bilinear prolongation (scaled by 1/4), needs valid ghosts (corners included) on the fine grid
+inline void restrict_full_weighting(Index I, const Grid2D& fine, Grid2D& coarse)
+{
+  constexpr double w[4] = { 1., 3., 3., 1. };
+  Index F = { static_cast<uint16_t>(2 * I.x - 3), static_cast<uint16_t>(2 * I.y - 3) };
+  double result = 0;
+  for (int b = 0; b < 4; b++)
+  {
+    for (int a = 0; a < 4; a++)
+    {
+      result += w[a] * w[b] * fine[F + a * Ix + b * Iy];
+    }
+  }
+  coarse[I] = result / 64.;
+}
+
+// bilinear interpolation of the coarse correction, needs valid ghosts (corners included) on the coarse grid
+inline void prolongate_correction(Index I, const Grid2D& coarse, Grid2D& fine)
+{
+  Index C = { static_cast<uint16_t>((I.x + 2) / 2), static_cast<uint16_t>((I.y + 2) / 2) };
+  Offset ox = (I.x % 2 == 0) ? -Ix : Ix;
+  Offset oy = (I.y % 2 == 0) ? -Iy : Iy;
+  fine[I] += 0.5625 * coarse[C] + 0.1875 * (coarse[C + ox] + coarse[C + oy]) + 0.0625 * coarse[C + ox + oy];
+}
+
 #endif // PRESSURESOLVERS_H_
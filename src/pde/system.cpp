@@ -6,7 +6,9 @@
 #include <cstdint>
 #include <cstdlib>
 #include <iostream>
+#include <omp.h>
 #include <pde/derivatives.h>
+#include <pde/initialguess.h>
 #include <pde/pressuresolvers.h>
 #include <pde/system.h>
 #include <type_traits>
@@ -14,59 +16,102 @@
 #include <utils/index.h>
 #include <utils/settings.h>
 
-inline void calculate_F(Index I, PDESystem& system)
+// F on the row of n faces starting at I
+inline void calculate_F_row(Index I, int n, PDESystem& system)
 {
-  auto& u = system.u;
-  auto& v = system.v;
-  auto& h = system.h;
-  auto& alpha = Settings::get().alpha;
-  system.F[I] = u[I] + system.dt * (1 / system.settings.re * (dd(Ix, u, I, h.x_squared) + dd(Iy, u, I, h.y_squared)) - dxx(Ix, u, u, I, h.x, alpha) - duv(Iy, u, v, I, h.y, alpha)) + system.settings.g[0];
+  const Rows u(system.u, I);
+  const Rows v(system.v, I);
+  double* __restrict F = system.F.row(I);
+  const InverseGridsize h(system.h);
+  const double alpha = Settings::get().alpha;
+  const double re = system.settings.re;
+  const double dt = system.dt;
+  const double g = system.settings.g[0];
+#pragma omp simd
+  for (int k = 0; k < n; k++)
+  {
+    double diffusion = dd<Axis::X>(u, k, h) + dd<Axis::Y>(u, k, h);
+    F[k] = u.centre[k] + dt * (1 / re * diffusion - dxx<Axis::X>(u, k, h, alpha) - duv<Axis::Y>(u, v, k, h, alpha)) + g;
+  }
 }
 
-inline void calculate_G(Index I, PDESystem& system)
+// G on the row of n faces starting at I
+inline void calculate_G_row(Index I, int n, PDESystem& system)
 {
-  auto& u = system.u;
-  auto& v = system.v;
-  auto& h = system.h;
-  auto& alpha = Settings::get().alpha;
-  system.G[I] = v[I] + system.dt * (1 / system.settings.re * (dd(Ix, v, I, h.x_squared) + dd(Iy, v, I, h.y_squared)) - dxx(Iy, v, v, I, h.y, alpha) - duv(Ix, u, v, I, h.x, alpha)) + +system.settings.g[1];
+  const Rows u(system.u, I);
+  const Rows v(system.v, I);
+  double* __restrict G = system.G.row(I);
+  const InverseGridsize h(system.h);
+  const double alpha = Settings::get().alpha;
+  const double re = system.settings.re;
+  const double dt = system.dt;
+  const double g = system.settings.g[1];
+#pragma omp simd
+  for (int k = 0; k < n; k++)
+  {
+    double diffusion = dd<Axis::X>(v, k, h) + dd<Axis::Y>(v, k, h);
+    G[k] = v.centre[k] + dt * (1 / re * diffusion - dxx<Axis::Y>(v, k, h, alpha) - duv<Axis::X>(v, u, k, h, alpha)) + g;
+  }
 }
 
-inline void update_u(Index I, PDESystem& system)
+inline void update_u_row(Index I, int n, PDESystem& system)
 {
-  system.u[I] = system.F[I] - system.dt * d(Ix, system.p, I, system.h.x);
-}
-void update_v(Index I, PDESystem& system)
-{
-  system.v[I] = system.G[I] - system.dt * d(Iy, system.p, I, system.h.y);
+  double* __restrict u = system.u.row(I);
+  const double* __restrict F = system.F.row(I);
+  const Rows p(system.p, I);
+  const InverseGridsize h(system.h);
+  const double dt = system.dt;
+#pragma omp simd
+  for (int k = 0; k < n; k++)
+  {
+    u[k] = F[k] - dt * d<Axis::X>(p, k, h);
+  }
 }
 
-void solve_pressure(PDESystem& system)
+inline void update_v_row(Index I, int n, PDESystem& system)
 {
-  ProfileScope("Pressure Solver");
-  switch (Settings::get().pressureSolver) // Settings::get().pressureSolver)
-  {
-  case Settings::CG:
-  {
-    static auto solver = CGSolver(system);
-    solve(solver, system);
-    break;
-  }
-  default:
+  double* __restrict v = system.v.row(I);
+  const double* __restrict G = system.G.row(I);
+  const Rows p(system.p, I);
+  const InverseGridsize h(system.h);
+  const double dt = system.dt;
+#pragma omp simd
+  for (int k = 0; k < n; k++)
   {
-    auto solver = SORSolver();
-    solve(solver, system);
-    break;
-  }
+    v[k] = G[k] - dt * d<Axis::Y>(p, k, h);
   }
 }
 
-inline void calculate_pressure_rhs(Index I, PDESystem& system)
+PDESystem::PDESystem(const Settings& settings, const Partitioning::MPIInfo& mpiInfo)
+  : settings(settings)
+  , begin({ 2, 2 })
+  , end(Index(mpiInfo.nCells[0] + 1, mpiInfo.nCells[1] + 1))
+  , p(Grid2D(begin, end, { begin, end }))
+  , u(Grid2D((mpiInfo.left_neighbor >= 0) ? begin - Ix : begin, (mpiInfo.right_neighbor >= 0) ? end : end - Ix, { begin, end }))
+  , v(Grid2D((mpiInfo.bottom_neighbor >= 0) ? begin - Iy : begin, (mpiInfo.top_neighbor >= 0) ? end : end - Iy, { begin, end }))
+  , F(Grid2D((mpiInfo.left_neighbor >= 0) ? begin - Ix : begin, (mpiInfo.right_neighbor >= 0) ? end : end - Ix))
+  , G(Grid2D((mpiInfo.bottom_neighbor >= 0) ? begin - Iy : begin, (mpiInfo.top_neighbor >= 0) ? end : end - Iy))
+  , rhs(Grid2D(begin, end))
+  , h(Gridsize(settings))
+  , partitioning(mpiInfo)
+  , solvers(std::make_unique<PressureSolverRegistry>())
+  , history(std::make_unique<PressureHistory>(*this)) { };
+
+PDESystem::~PDESystem() = default;
+
+// the differences of F and G end at the faces of the cell, they start one face before it
+inline void calculate_pressure_rhs_row(Index I, int n, PDESystem& system)
 {
-  auto& F = system.F;
-  auto& G = system.G;
-  auto& h = system.h;
-  system.rhs[I] = (1 / system.dt) * (d(Ix, F, I - Ix, h.x) + d(Iy, G, I - Iy, h.y));
+  double* __restrict rhs = system.rhs.row(I);
+  const Rows F(system.F, I - Ix);
+  const Rows G(system.G, I - Iy);
+  const InverseGridsize h(system.h);
+  const double dt = system.dt;
+#pragma omp simd
+  for (int k = 0; k < n; k++)
+  {
+    rhs[k] = (1 / dt) * (d<Axis::X>(F, k, h) + d<Axis::Y>(G, k, h));
+  }
 }
 
 inline void set_with_neighbour(Index I, Offset O, Grid2D& array, double value)
@@ -110,6 +155,44 @@ void compute_dt(PDESystem& system)
   system.dt = std::max(1e-10, system.dt);
 }
 
+// F, G and the pressure rhs in one pass over the rows. Every thread walks a band of rows and forms the
+// rhs of a row right after its F and G, while the rows are still in cache. The rhs of the first row of
+// a band needs G of the row below, which belongs to the previous band, it waits for all bands
+static void predictor(PDESystem& system)
+{
+  ProfileScope("Predictor");
+  const Range u = system.u.range;
+  const Range v = system.v.range;
+  const Range p = system.p.range;
+  const int u_length = u.end.x - u.begin.x + 1;
+  const int v_length = v.end.x - v.begin.x + 1;
+  const int p_length = p.end.x - p.begin.x + 1;
+  const int first = std::min({ u.begin.y, v.begin.y, p.begin.y });
+  const int last = std::max({ u.end.y, v.end.y, p.end.y });
+  auto in = [](const Range& r, int j) { return r.begin.y <= j && j <= r.end.y; };
+
+#pragma omp parallel if (p.count() >= PARALLEL_CELLS)
+  {
+    const int threads = omp_get_num_threads();
+    const int thread = omp_get_thread_num();
+    const int begin = first + (last - first + 1) * thread / threads;
+    const int end = first + (last - first + 1) * (thread + 1) / threads - 1;
+    for (int j = begin; j <= end; j++)
+    {
+      uint16_t y = static_cast<uint16_t>(j);
+      if (in(u, j))
+        calculate_F_row(Index { u.begin.x, y }, u_length, system);
+      if (in(v, j))
+        calculate_G_row(Index { v.begin.x, y }, v_length, system);
+      if (in(p, j) && j > begin)
+        calculate_pressure_rhs_row(Index { p.begin.x, y }, p_length, system);
+    }
+#pragma omp barrier
+    if (begin <= end && in(p, begin))
+      calculate_pressure_rhs_row(Index { p.begin.x, static_cast<uint16_t>(begin) }, p_length, system);
+  }
+}
+
 void update_velocity(PDESystem& system)
 {
   // Range u_inner = Range { system.u.begin + II, system.u.end - II };
@@ -118,31 +201,45 @@ void update_velocity(PDESystem& system)
   // Boundaries v_border = Boundaries(v_inner.begin, v_inner.end);
   //  broadcast(update_u, u_border.all, system);
   //  broadcast(update_v, v_border.all, system);
-  broadcast(update_u, system.u.range, system);
-  broadcast(update_v, system.v.range, system);
-  MPI_COMM_BUFFER* u_comm_buffer = new MPI_COMM_BUFFER(system.u, system.u.boundary.u_ghosts(), MPI_COMM_WORLD, system.partitioning, 16);
-  MPI_COMM_BUFFER* v_comm_buffer = new MPI_COMM_BUFFER(system.v, system.v.boundary.v_ghosts(), MPI_COMM_WORLD, system.partitioning, 32);
+  // u and v in one pass over the rows, each row of p is read once
+  const Range u = system.u.range;
+  const Range v = system.v.range;
+  const int u_length = u.end.x - u.begin.x + 1;
+  const int v_length = v.end.x - v.begin.x + 1;
+#pragma omp parallel for schedule(static) if (u.count() >= PARALLEL_CELLS)
+  for (int j = std::min(u.begin.y, v.begin.y); j <= std::max(u.end.y, v.end.y); j++)
+  {
+    uint16_t y = static_cast<uint16_t>(j);
+    if (u.begin.y <= j && j <= u.end.y)
+      update_u_row(Index { u.begin.x, y }, u_length, system);
+    if (v.begin.y <= j && j <= v.end.y)
+      update_v_row(Index { v.begin.x, y }, v_length, system);
+  }
+  MPI_COMM_BUFFER* u_comm_buffer = new MPI_COMM_BUFFER(system.u, system.u.boundary.u_ghosts(), Partitioning::getCommunicator(), system.partitioning, 16);
+  MPI_COMM_BUFFER* v_comm_buffer = new MPI_COMM_BUFFER(system.v, system.v.boundary.v_ghosts(), Partitioning::getCommunicator(), system.partitioning, 32);
   delete u_comm_buffer;
   delete v_comm_buffer;
 }
 
-void step(PDESystem& system, double time)
+void step(PDESystem& system, double time, double until)
 {
   ProfileScope("Time Step");
 
   set_uv_boundary(system);
 
   compute_dt(system);
+  // the remaining interval is split into equal steps, which avoids a tiny last one
+  if (until < INFINITY)
+    system.dt = (until - time) / std::ceil((until - time) / system.dt);
 
   broadcast_halo(copy, system.F.boundary, system.u, system.F);
   broadcast_halo(copy, system.G.boundary, system.v, system.G);
 
-  broadcast(calculate_F, system.u.range, system);
-  broadcast(calculate_G, system.v.range, system);
-
-  broadcast(calculate_pressure_rhs, system.p.range, system);
+  predictor(system);
 
+  initial_guess(*system.history, system, time + system.dt);
   solve_pressure(system);
+  record_pressure(*system.history, system, time + system.dt);
 
   update_velocity(system);
 
@@ -4,6 +4,7 @@
 #include <cmath>
 #include <cstdint>
 #include <grid/grid.h>
+#include <memory>
 #include <utils/index.h>
 #include <utils/partitioning.h>
 #include <utils/settings.h>
@@ -22,8 +23,18 @@ struct Gridsize
     , y_squared(y * y)
   {
   }
+  Gridsize(double x, double y)
+    : x(x)
+    , y(y)
+    , x_squared(x * x)
+    , y_squared(y * y)
+  {
+  }
 };
 
+struct PressureSolverRegistry;
+struct PressureHistory;
+
 struct PDESystem
 {
   const Settings& settings;
@@ -39,25 +50,19 @@ struct PDESystem
   Grid2D rhs;
   const Gridsize h;
   Partitioning::MPIInfo partitioning;
+  // pressure solver workspaces, kept across time steps
+  std::unique_ptr<PressureSolverRegistry> solvers;
+  // solved pressures of the last time steps for the initial guess
+  std::unique_ptr<PressureHistory> history;
 
-  PDESystem(const Settings& settings, const Partitioning::MPIInfo& mpiInfo)
-    : settings(settings)
-    , begin({ 2, 2 })
-    , end(Index(mpiInfo.nCells[0] + 1, mpiInfo.nCells[1] + 1))
-    , p(Grid2D(begin, end, { begin, end }))
-    , u(Grid2D((mpiInfo.left_neighbor >= 0) ? begin - Ix : begin, (mpiInfo.right_neighbor >= 0) ? end : end - Ix, { begin, end }))
-    , v(Grid2D((mpiInfo.bottom_neighbor >= 0) ? begin - Iy : begin, (mpiInfo.top_neighbor >= 0) ? end : end - Iy, { begin, end }))
-    , F(Grid2D((mpiInfo.left_neighbor >= 0) ? begin - Ix : begin, (mpiInfo.right_neighbor >= 0) ? end : end - Ix))
-    , G(Grid2D((mpiInfo.bottom_neighbor >= 0) ? begin - Iy : begin, (mpiInfo.top_neighbor >= 0) ? end : end - Iy))
-    , rhs(Grid2D(begin, end))
-    , h(Gridsize(settings))
-    , partitioning(mpiInfo) {
-    };
+  PDESystem(const Settings& settings, const Partitioning::MPIInfo& mpiInfo);
+  ~PDESystem();
   PDESystem(const PDESystem&) = delete;
   PDESystem& operator=(const PDESystem&) = delete;
 };
 
-void step(PDESystem& system, double time);
+// advances by one time step, the steps before `until` are shortened to end exactly there
+void step(PDESystem& system, double time, double until = INFINITY);
 void print_pde_system(const PDESystem& sys);
 
 double interpolate_u(const PDESystem& sys, const Grid2D& field, Index I);
@@ -7,16 +7,21 @@
 #include <cstdint>
 #include <grid/grid.h>
 #include <pde/system.h>
+#include <type_traits>
 #include <utils/index.h>
 
+// the blocks of one colour are independent and run on all threads. An operator that returns its
+// residual instead of writing a shared maximum can run threaded, the maximum of the results is returned
 template <typename Operator, typename... Args>
-void broadcast_blackred(Operator&& O, int parity, Range r, Args&&... args)
+auto broadcast_blackred(Operator&& O, int parity, Range r, Args&&... args)
 {
   ProfileScope("Black Iteration");
   constexpr uint16_t BLOCK_SIZE_X = 32;
   constexpr uint16_t BLOCK_SIZE_Y = 32;
+  constexpr bool reduces = !std::is_void_v<std::invoke_result_t<Operator, Index, Args...>>;
+  double result = 0;
 
-  // #pragma omp loop bind(parallel) collapse(2)
+#pragma omp parallel for collapse(2) schedule(static) reduction(max : result) if (r.count() >= PARALLEL_CELLS)
   for (uint16_t by = r.begin.y; by <= r.end.y; by += BLOCK_SIZE_Y)
   {
     for (uint16_t bx = r.begin.x; bx <= r.end.x; bx += BLOCK_SIZE_X)
@@ -28,18 +33,26 @@ void broadcast_blackred(Operator&& O, int parity, Range r, Args&&... args)
       {
         for (uint16_t i = bx; i <= x_max; i = i + 2)
         {
-          std::forward<Operator>(O)(Index { i, j }, std::forward<Args>(args)...);
+          if constexpr (reduces)
+            result = std::max<double>(result, O(Index { i, j }, args...));
+          else
+            O(Index { i, j }, args...);
         }
       }
       for (uint16_t j = by + 1 - parity; j <= y_max; j = j + 2)
       {
         for (uint16_t i = bx + 1; i <= x_max; i = i + 2)
         {
-          std::forward<Operator>(O)(Index { i, j }, std::forward<Args>(args)...);
+          if constexpr (reduces)
+            result = std::max<double>(result, O(Index { i, j }, args...));
+          else
+            O(Index { i, j }, args...);
         }
       }
     }
   }
+  if constexpr (reduces)
+    return result;
 }
 
 template <typename Operator, typename... Args>
@@ -89,6 +102,41 @@ void broadcast(Operator&& O, Range r, Args&&... args)
   }
 };
 
+// lexicographic sweep that runs the 32x32 blocks of one anti-diagonal in parallel. A block only
+// depends on its left and lower neighbours, which were finished on the previous diagonal, so the
+// result is identical to the sequential broadcast. Returns the maximum of the operator results
+template <typename Operator, typename... Args>
+double broadcast_wavefront(Operator&& O, Range r, Args&&... args)
+{
+  ProfileScope("Wavefront Broadcast");
+  constexpr int BLOCK_SIZE_X = 32;
+  constexpr int BLOCK_SIZE_Y = 32;
+  const int blocks_x = (r.end.x - r.begin.x) / BLOCK_SIZE_X + 1;
+  const int blocks_y = (r.end.y - r.begin.y) / BLOCK_SIZE_Y + 1;
+  double result = 0;
+#pragma omp parallel reduction(max : result)
+  for (int diagonal = 0; diagonal < blocks_x + blocks_y - 1; diagonal++)
+  {
+    // the implicit barrier at the end of the loop separates the diagonals
+#pragma omp for schedule(static)
+    for (int block_x = std::max(0, diagonal - blocks_y + 1); block_x <= std::min(diagonal, blocks_x - 1); block_x++)
+    {
+      uint16_t bx = r.begin.x + block_x * BLOCK_SIZE_X;
+      uint16_t by = r.begin.y + (diagonal - block_x) * BLOCK_SIZE_Y;
+      uint16_t y_max = std::min<uint16_t>(by + BLOCK_SIZE_Y - 1, r.end.y);
+      uint16_t x_max = std::min<uint16_t>(bx + BLOCK_SIZE_X - 1, r.end.x);
+      for (uint16_t j = by; j <= y_max; j++)
+      {
+        for (uint16_t i = bx; i <= x_max; i++)
+        {
+          result = std::max(result, O(Index { i, j }, args...));
+        }
+      }
+    }
+  }
+  return result;
+};
+
 template <typename Operator, size_t S, typename... Args>
 void broadcast(Operator&& O, std::array<std::tuple<Range, Offset>, S> ranges, Args&&... args)
 {
@@ -114,7 +162,7 @@ void parallel_broadcast(Operator&& O, Range r, Args&&... args)
   ProfileScope("Parallel Broadcast");
   constexpr uint16_t BLOCK_SIZE_X = 16;
   constexpr uint16_t BLOCK_SIZE_Y = 16;
-  // #pragma omp for collapse(2)
+#pragma omp parallel for collapse(2) schedule(static) if (r.count() >= PARALLEL_CELLS)
   for (uint16_t by = r.begin.y; by <= r.end.y; by += BLOCK_SIZE_Y)
   {
     for (uint16_t bx = r.begin.x; bx <= r.end.x; bx += BLOCK_SIZE_X)
@@ -133,13 +181,27 @@ void parallel_broadcast(Operator&& O, Range r, Args&&... args)
   }
 };
 
+// calls the row kernel K(I, n, args...) with the first cell I and the length n of every row of the range.
+// The kernels walk their rows through pointers, so the inner loops vectorize over a plain counter
+template <typename Kernel, typename... Args>
+void broadcast_rows(Kernel&& K, Range r, Args&&... args)
+{
+  ProfileScope("Row Broadcast");
+  const int n = r.end.x - r.begin.x + 1;
+#pragma omp parallel for schedule(static) if (r.count() >= PARALLEL_CELLS)
+  for (int j = r.begin.y; j <= r.end.y; j++)
+  {
+    K(Index { r.begin.x, static_cast<uint16_t>(j) }, n, args...);
+  }
+};
+
 template <typename Operator, typename... Args>
 void test_broadcast(Operator&& O, Range r, Args&&... args)
 {
   ProfileScope("Jacoby Broadcast");
   constexpr uint16_t BLOCK_SIZE_X = 16;
   constexpr uint16_t BLOCK_SIZE_Y = 16;
-  // #pragma omp parallel for schedule(static) collapse(2)
+#pragma omp parallel for collapse(2) schedule(static) if (r.count() >= PARALLEL_CELLS)
   for (uint16_t by = r.begin.y; by <= r.end.y; by += BLOCK_SIZE_Y)
   {
     for (uint16_t bx = r.begin.x; bx <= r.end.x; bx += BLOCK_SIZE_X)
@@ -0,0 +1,74 @@
+#include "convergence.h"
+#include "utils/partitioning.h"
+#include "utils/profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <mpi.h>
+
+ConvergenceMonitor::ConvergenceMonitor(double epsilon, int lag, int min_interval, int max_interval)
+  : epsilon(epsilon)
+  , lag(lag)
+  , min_interval(min_interval)
+  , max_interval(max_interval)
+{
+}
+
+void ConvergenceMonitor::start()
+{
+  finish();
+  // the contraction of the previous solve overestimates the iterations of the early transient
+  rate = 0.;
+  residual = 0.;
+  residual_iteration = -1;
+  completed_iteration = -1;
+  next_check = 0;
+  interval = min_interval;
+}
+
+void ConvergenceMonitor::complete(int iteration)
+{
+  ProfileScope("Convergence Check");
+  MPI_Wait(&request, MPI_STATUS_IGNORE);
+  if (residual_iteration >= 0 && residual > 0. && global > 0.)
+    rate = std::pow(global / residual, 1. / (posted_iteration - residual_iteration));
+  residual = global;
+  residual_iteration = posted_iteration;
+  completed_iteration = iteration;
+
+  if (rate <= 0.)
+    interval = min_interval;
+  else if (rate < 1.)
+    // half of the predicted distance, the checks close in on the converged iteration
+    interval = static_cast<int>(std::log(epsilon / residual) / std::log(rate) / 2.);
+  // a growing residual gives no prediction, the interval is kept
+  interval = std::clamp(interval, min_interval, max_interval);
+  next_check = posted_iteration + interval;
+}
+
+bool ConvergenceMonitor::due(int iteration)
+{
+  if (request != MPI_REQUEST_NULL && iteration >= posted_iteration + lag)
+    complete(iteration);
+  if (checked(iteration) && residual < epsilon)
+    return false;
+  return request == MPI_REQUEST_NULL && iteration >= next_check;
+}
+
+bool ConvergenceMonitor::converged(int iteration, double local_residual)
+{
+  if (due(iteration))
+  {
+    local = local_residual;
+    posted_iteration = iteration;
+    MPI_Iallreduce(&local, &global, 1, MPI_DOUBLE, MPI_MAX, Partitioning::getCommunicator(), &request);
+    if (lag == 0)
+      complete(iteration);
+  }
+  return checked(iteration) && residual < epsilon;
+}
+
+void ConvergenceMonitor::finish()
+{
+  if (request != MPI_REQUEST_NULL)
+    MPI_Wait(&request, MPI_STATUS_IGNORE);
+}
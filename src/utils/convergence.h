@@ -0,0 +1,47 @@
+#ifndef CONVERGENCE_H_
+#define CONVERGENCE_H_
+
+#include <mpi.h>
+
+// lagged global convergence test for the iterative solvers. The maximum of the local residuals
+// is reduced with MPI_Iallreduce and only waited for `lag` iterations later, the solver keeps
+// sweeping in the meantime. The decision is taken at the same iteration on every rank.
+// The distance between two reductions follows the contraction rate observed between the
+// previous ones and shrinks towards the predicted convergence.
+struct ConvergenceMonitor
+{
+  double epsilon;
+  int lag;
+  int min_interval;
+  int max_interval;
+  // contraction of the residual per iteration between the last two completed reductions
+  double rate = 0.;
+  // residual of the last completed reduction and the iteration it was posted at
+  double residual = 0.;
+  int residual_iteration = -1;
+
+  ConvergenceMonitor(double epsilon, int lag = 1, int min_interval = 1, int max_interval = 64);
+
+  // has to be called before the first iteration of every solve
+  void start();
+  // completes a reduction that is due, true if the local residual of this iteration is going to be reduced
+  bool due(int iteration);
+  // posts the local residual if due, true once a completed reduction is below epsilon
+  bool converged(int iteration, double local_residual);
+  // true if a reduction completed in this iteration, residual and rate are then updated
+  bool checked(int iteration) const { return completed_iteration == iteration; };
+  // completes an outstanding reduction, the solver may stop without converging
+  void finish();
+
+private:
+  MPI_Request request = MPI_REQUEST_NULL;
+  double local = 0.;
+  double global = 0.;
+  int posted_iteration = -1;
+  int completed_iteration = -1;
+  int next_check = 0;
+  int interval = 1;
+  void complete(int iteration);
+};
+
+#endif // CONVERGENCE_H_
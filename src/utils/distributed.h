@@ -20,17 +20,19 @@ inline size_t len(Range r)
   return (r.end.x - r.begin.x + 1) * (r.end.y - r.begin.y + 1);
 };
 
-struct MPI_COMM_BUFFER
+// halo exchange of a grid with elements of type T
+template <typename T>
+struct BasicCommBuffer
 {
   MPI_Comm comm;
-  Grid2D& comm_array;
+  BasicGrid2D<T>& comm_array;
   std::array<std::tuple<Range, Offset>, 4> communication_boundary;
   std::array<MPI_Request, 4> requestS;
   std::array<MPI_Request, 4> requestR;
-  std::array<double*, 4> sendbuffer;
-  std::array<double*, 4> recivebuffer;
+  std::array<T*, 4> sendbuffer;
+  std::array<T*, 4> recivebuffer;
 
-  MPI_COMM_BUFFER(Grid2D& comm_array, std::array<std::tuple<Range, Offset>, 4> ghosts, MPI_Comm comm, Partitioning::MPIInfo& info, int id = 0)
+  BasicCommBuffer(BasicGrid2D<T>& comm_array, std::array<std::tuple<Range, Offset>, 4> ghosts, MPI_Comm comm, Partitioning::MPIInfo& info, int id = 0)
     : comm(comm)
     , comm_array(comm_array)
     , communication_boundary(ghosts)
@@ -47,8 +49,8 @@ struct MPI_COMM_BUFFER
       {
 
         auto [r, o] = ghosts[i];
-        recivebuffer[i] = (double*)malloc(len(r) * sizeof(double));
-        MPI_Irecv(recivebuffer[i], len(r), MPI_DOUBLE, info.neighbours()[i][0], info.neighbours()[i][1] + id, comm, &requestR[i]);
+        recivebuffer[i] = (T*)malloc(len(r) * sizeof(T));
+        MPI_Irecv(recivebuffer[i], len(r), mpi_type<T>(), info.neighbours()[i][0], info.neighbours()[i][1] + id, comm, &requestR[i]);
       }
     }
 
@@ -63,11 +65,11 @@ struct MPI_COMM_BUFFER
         // DebugF("Allocating sendrevieve buffers of size {} from rank {}", len(r), info.rank);
         // DebugF("Range : {{x={} , y={} }} -> {{x={} , y={} }}", r.begin.x, r.begin.y, r.end.x, r.end.y);
         // DebugF("Offset : {{x={} , y={} }}", o.x, o.y);
-        sendbuffer[i] = (double*)malloc(len(r) * sizeof(double));
+        sendbuffer[i] = (T*)malloc(len(r) * sizeof(T));
         // recivebuffer[i] = (double*)malloc(len(r) * sizeof(double));
         comm_array.get(sendbuffer[i], r - o);
         // DebugF("Request {}", request[i]);
-        MPI_Isend(sendbuffer[i], len(r), MPI_DOUBLE, info.neighbours()[i][0], i + id, comm, &requestS[i]);
+        MPI_Isend(sendbuffer[i], len(r), mpi_type<T>(), info.neighbours()[i][0], i + id, comm, &requestS[i]);
         // MPI_Irecv(recivebuffer[i], len(r), MPI_DOUBLE, info.neighbours()[i][0], info.neighbours()[i][1] + id, comm, &requestR[i]);
         //  MPI_Isendrecv(
         //    sendbuffer[i],
@@ -85,7 +87,7 @@ struct MPI_COMM_BUFFER
       }
     }
   };
-  ~MPI_COMM_BUFFER()
+  ~BasicCommBuffer()
   {
     ProfileScope("MPI Communication Wait");
 
@@ -128,8 +130,11 @@ struct MPI_COMM_BUFFER
   }
 };
 
-template <typename Operator, typename... Args>
-void distributed_broadcast(Operator&& O, Partitioning::MPIInfo p, Range r, Grid2D& comm_array, Args&&... args)
+using MPI_COMM_BUFFER = BasicCommBuffer<double>;
+using MPI_COMM_BUFFER_FLOAT = BasicCommBuffer<float>;
+
+template <typename Operator, typename T, typename... Args>
+void distributed_broadcast(Operator&& O, Partitioning::MPIInfo p, Range r, BasicGrid2D<T>& comm_array, Args&&... args)
 {
   assert(r.end.x - r.begin.x > 2);
   assert(r.end.y - r.begin.y > 2);
@@ -140,9 +145,30 @@ void distributed_broadcast(Operator&& O, Partitioning::MPIInfo p, Range r, Grid2
   //  copy boundary sendbuff
   broadcast(std::forward<Operator>(O), border.unique(), std::forward<Args>(args)...);
   // broadcast(std::forward<Operator>(O), r, std::forward<Args>(args)...);
-  MPI_COMM_BUFFER* comm_buffer = new MPI_COMM_BUFFER(comm_array, ghosts.all, MPI_COMM_WORLD, p);
+  auto* comm_buffer = new BasicCommBuffer<T>(comm_array, ghosts.all, Partitioning::getCommunicator(), p);
   broadcast(std::forward<Operator>(O), inner, std::forward<Args>(args)...);
   delete comm_buffer;
 };
 
+// applies a stencil operator that reads the halo of comm_array, the inner cells are computed while the halo is exchanged
+template <typename Operator, typename T, typename... Args>
+void stencil_broadcast(Operator&& O, Partitioning::MPIInfo p, Range r, BasicGrid2D<T>& comm_array, Args&&... args)
+{
+  if (r.end.x - r.begin.x <= 2 || r.end.y - r.begin.y <= 2)
+  {
+    // coarse multigrid levels, too small to split off the inner cells
+    auto* comm_buffer = new BasicCommBuffer<T>(comm_array, comm_array.boundary.all, Partitioning::getCommunicator(), p);
+    delete comm_buffer;
+    broadcast(std::forward<Operator>(O), r, std::forward<Args>(args)...);
+    return;
+  }
+  Range inner = Range { r.begin + II, r.end - II };
+  Boundaries border = Boundaries(inner.begin, inner.end);
+
+  auto* comm_buffer = new BasicCommBuffer<T>(comm_array, comm_array.boundary.all, Partitioning::getCommunicator(), p);
+  parallel_broadcast(std::forward<Operator>(O), inner, std::forward<Args>(args)...);
+  delete comm_buffer;
+  broadcast(std::forward<Operator>(O), border.unique(), std::forward<Args>(args)...);
+};
+
 #endif // DISTRIBUTED_H_
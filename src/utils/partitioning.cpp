@@ -1,10 +1,110 @@
 #include "utils/partitioning.h"
 #include "utils/index.h"
+#include "utils/Logger.h"
+#include <algorithm>
 #include <cmath>
+#include <cstdlib>
 #include <mpi.h>
+#include <omp.h>
+#include <sched.h>
+#include <unistd.h>
 #include <utils/settings.h>
+#include <vector>
 
 namespace Partitioning {
+static MPI_Comm communicator = MPI_COMM_WORLD;
+
+MPI_Comm getCommunicator() { return communicator; }
+
+void setCommunicator(MPI_Comm comm) { communicator = comm; }
+
+void pinThreads(int threads)
+{
+  cpu_set_t allowed;
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+  {
+    if (threads > 0)
+      omp_set_num_threads(threads);
+    return;
+  }
+  std::vector<int> cores;
+  for (int core = 0; core < CPU_SETSIZE; core++)
+  {
+    if (CPU_ISSET(core, &allowed))
+      cores.push_back(core);
+  }
+
+  // ranks of the node with the same mask share its cores, whether they are unbound and see the
+  // whole node or the launcher bound them to a common socket or NUMA domain
+  MPI_Comm node;
+  MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &node);
+  int local_rank, local_size;
+  MPI_Comm_rank(node, &local_rank);
+  MPI_Comm_size(node, &local_size);
+  std::vector<cpu_set_t> masks(local_size);
+  MPI_Allgather(&allowed, sizeof(cpu_set_t), MPI_BYTE, masks.data(), sizeof(cpu_set_t), MPI_BYTE, node);
+  MPI_Comm_free(&node);
+  int share = 0;
+  int sharing = 0;
+  for (int r = 0; r < local_size; r++)
+  {
+    if (CPU_EQUAL(&masks[r], &allowed))
+    {
+      share += r < local_rank;
+      sharing++;
+    }
+  }
+  // each rank takes a contiguous part, more ranks than cores stack up on single cores
+  size_t first = cores.size() * share / sharing;
+  size_t last = cores.size() * (share + 1) / sharing;
+  cores = std::vector<int>(cores.begin() + first, cores.begin() + std::max(last, first + 1));
+
+  if (threads > 0)
+    omp_set_num_threads(threads);
+  else if (!std::getenv("OMP_NUM_THREADS"))
+    omp_set_num_threads(cores.size());
+  // an explicit binding of the OpenMP runtime wins
+  if (std::getenv("OMP_PROC_BIND") || std::getenv("OMP_PLACES"))
+    return;
+
+#pragma omp parallel
+  {
+    // the threads are spread evenly over the cores, neighbouring threads work on neighbouring rows
+    size_t core = cores[omp_get_thread_num() * cores.size() / omp_get_num_threads()];
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(core, &set);
+    sched_setaffinity(0, sizeof(set), &set);
+  }
+  DebugF("rank {} of the node runs {} threads on {} cores", local_rank, omp_get_max_threads(), cores.size());
+}
+
+// cells of the given rank in a px x py split, the leftover cells go to the last column and the bottom row
+static void localCells(int nCellsX, int nCellsY, int px, int py, int rank, int cells[2])
+{
+  if (nCellsX % px == 0 && nCellsY % py == 0)
+  {
+    cells[0] = nCellsX / px;
+    cells[1] = nCellsY / py;
+  } else if (nCellsY % py != 0 && rank >= (py - 1) * px && (rank + 1) % px != 0)
+  {
+    cells[0] = std::floor(nCellsX / px);
+    cells[1] = (nCellsY / py) + nCellsY % py;
+  } else if (nCellsX % px != 0 && (rank + 1) % px == 0 && rank <= (py - 1) * px)
+  {
+    cells[0] = (nCellsX / px) + nCellsX % px;
+    cells[1] = std::floor(nCellsY / py);
+  } else if ((rank + 1) % px == 0 && rank >= (py - 1) * px)
+  {
+    cells[0] = (nCellsX / px) + nCellsX % px;
+    cells[1] = (nCellsY / py) + nCellsY % py;
+  } else
+  {
+    cells[0] = std::floor(nCellsX / px);
+    cells[1] = std::floor(nCellsY / py);
+  }
+}
+
 void setMPIInfo(MPIInfo& mpiInfo, const Settings& settings, int rank, int size)
 {
   mpiInfo.rank = rank;
@@ -27,36 +127,26 @@ void setMPIInfo(MPIInfo& mpiInfo, const Settings& settings, int rank, int size)
     }
   };
 
-  int mpiCellsx;
-  int mpiCellsy;
+  localCells(nCellsX, nCellsY, px, py, rank, mpiInfo.nCells);
 
-  if (nCellsX % px == 0 && nCellsY % py == 0)
-  {
-    mpiCellsx = nCellsX / px;
-    mpiCellsy = nCellsY / py;
-  } else if (nCellsY % py != 0 && rank >= (py - 1) * px && (rank + 1) % px != 0)
-  {
-    mpiCellsx = std::floor(nCellsX / px);
-    mpiCellsy = (nCellsY / py) + nCellsY % py;
-  } else if (nCellsX % px != 0 && (rank + 1) % px == 0 && rank <= (py - 1) * px)
+  // global position of the first local cell, summed over the ranks to the left and below
+  mpiInfo.cellOffset[0] = 0;
+  mpiInfo.cellOffset[1] = 0;
+  for (int x = 0; x < rank % px; x++)
   {
-    mpiCellsx = (nCellsX / px) + nCellsX % px;
-    mpiCellsy = std::floor(nCellsY / py);
-  } else if ((rank + 1) % px == 0 && rank >= (py - 1) * px)
-  {
-    mpiCellsx = (nCellsX / px) + nCellsX % px;
-    mpiCellsy = (nCellsY / py) + nCellsY % py;
-  } else
+    int cells[2];
+    localCells(nCellsX, nCellsY, px, py, (rank / px) * px + x, cells);
+    mpiInfo.cellOffset[0] += cells[0];
+  }
+  for (int y = py - 1; y > rank / px; y--)
   {
-    mpiCellsx = std::floor(nCellsX / px);
-    mpiCellsy = std::floor(nCellsY / py);
+    int cells[2];
+    localCells(nCellsX, nCellsY, px, py, y * px + rank % px, cells);
+    mpiInfo.cellOffset[1] += cells[1];
   }
 
-  mpiInfo.nCells[0] = mpiCellsx;
-  mpiInfo.nCells[1] = mpiCellsy;
-
-  mpiInfo.nCellsWithGhostcells[0] = mpiCellsx + 2;
-  mpiInfo.nCellsWithGhostcells[1] = mpiCellsy + 2;
+  mpiInfo.nCellsWithGhostcells[0] = mpiInfo.nCells[0] + 2;
+  mpiInfo.nCellsWithGhostcells[1] = mpiInfo.nCells[1] + 2;
 
   int lefneighbor;
   int rightneighbor;
@@ -177,7 +267,7 @@ const std::vector<MPIInfo>& getInfos()
   int currentSize = 1;
   if (initialized)
   {
-    MPI_Comm_size(MPI_COMM_WORLD, &currentSize);
+    MPI_Comm_size(Partitioning::getCommunicator(), &currentSize);
   }
 
   // If the cached vector doesn't match the current number of ranks, rebuild it
@@ -17,6 +17,7 @@ struct MPIInfo
   int right_neighbor;
   int nCells[2];
   int nCellsWithGhostcells[2];
+  int cellOffset[2]; // global position of the first local cell, counted from the bottom left
 
   inline std::array<std::array<int, 2>, 4> neighbours() const
   {
@@ -26,6 +27,13 @@ struct MPIInfo
   const Index getGridPos() const;
 };
 void setMPIInfo(MPIInfo& mpiInfo, const Settings& settings, int rank, int size);
+// communicator of the spatial decomposition, MPI_COMM_WORLD unless the ranks are split into time slices
+MPI_Comm getCommunicator();
+void setCommunicator(MPI_Comm comm);
+// sets the OpenMP threads of the rank and pins every thread to one core of the rank. Ranks of a node
+// with the same affinity mask share its cores out among themselves, threads = 0 runs one thread per
+// core of the share unless OMP_NUM_THREADS is set
+void pinThreads(int threads);
 const std::vector<MPIInfo>& getInfos();
 const MPIInfo& getInfo(size_t x, size_t y);
 
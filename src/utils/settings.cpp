@@ -8,6 +8,7 @@
 #include <iomanip>
 #include <iostream>
 #include <sstream>
+#include <string>
 
 static Settings globalSettings {};
 const Settings& Settings::get() { return globalSettings; }
@@ -164,10 +165,110 @@ void parseSettings(const std::string& input, Settings* settings)
         settings->pressureSolver = Settings::PressureSolver::BlackRed;
       else if (value.starts_with("Jacoby"))
         settings->pressureSolver = Settings::PressureSolver::Jacoby;
+      else if (value.starts_with("Multigrid"))
+        settings->pressureSolver = Settings::PressureSolver::Multigrid;
+      else if (value.starts_with("FFT"))
+        settings->pressureSolver = Settings::PressureSolver::FFT;
+      else if (value.starts_with("PipelinedCG"))
+        settings->pressureSolver = Settings::PressureSolver::PipelinedCG;
+      else if (value.starts_with("SStepCG"))
+        settings->pressureSolver = Settings::PressureSolver::SStepCG;
+      else if (value.starts_with("Chebyshev"))
+        settings->pressureSolver = Settings::PressureSolver::Chebyshev;
+      else if (value.starts_with("Zebra"))
+        settings->pressureSolver = Settings::PressureSolver::Zebra;
+      else if (value.starts_with("Cholesky"))
+        settings->pressureSolver = Settings::PressureSolver::Cholesky;
       else
         validLine = false;
-    } else if (compareToSecond(key, "omega"))
-      settings->omega = atof(value.c_str());
+    } else if (compareToSecond(key, "multigridCycle"))
+    {
+      if (value.starts_with("V"))
+        settings->multigridCycle = Settings::MultigridCycle::VCycle;
+      else if (value.starts_with("W"))
+        settings->multigridCycle = Settings::MultigridCycle::WCycle;
+      else if (value.starts_with("F"))
+        settings->multigridCycle = Settings::MultigridCycle::FCycle;
+      else
+        validLine = false;
+    } else if (compareToSecond(key, "multigridSmoother"))
+    {
+      if (value.starts_with("BlackRed"))
+        settings->multigridSmoother = Settings::PressureSolver::BlackRed;
+      else if (value.starts_with("SOR"))
+        settings->multigridSmoother = Settings::PressureSolver::SOR;
+      else if (value.starts_with("Chebyshev"))
+        settings->multigridSmoother = Settings::PressureSolver::Chebyshev;
+      else if (value.starts_with("Zebra"))
+        settings->multigridSmoother = Settings::PressureSolver::Zebra;
+      else
+        validLine = false;
+    } else if (compareToSecond(key, "multigridPreSmoothing"))
+      settings->multigridPreSmoothing = atoi(value.c_str());
+    else if (compareToSecond(key, "multigridPostSmoothing"))
+      settings->multigridPostSmoothing = atoi(value.c_str());
+    else if (compareToSecond(key, "multigridCoarseIterations"))
+      settings->multigridCoarseIterations = atoi(value.c_str());
+    else if (compareToSecond(key, "preconditioner"))
+    {
+      if (value.starts_with("Jacobi"))
+        settings->preconditioner = Settings::Preconditioner::Jacobi;
+      else if (value.starts_with("Multigrid"))
+        settings->preconditioner = Settings::Preconditioner::Multigrid;
+      else if (value.starts_with("Chebyshev"))
+        settings->preconditioner = Settings::Preconditioner::Chebyshev;
+      else if (value.starts_with("BlockJacobi"))
+        settings->preconditioner = Settings::Preconditioner::BlockJacobi;
+      else if (value.starts_with("SSOR"))
+        settings->preconditioner = Settings::Preconditioner::SSOR;
+      else if (value.starts_with("IncompleteCholesky"))
+        settings->preconditioner = Settings::Preconditioner::IncompleteCholesky;
+      else if (value.starts_with("AMG"))
+        settings->preconditioner = Settings::Preconditioner::AMG;
+      else
+        validLine = false;
+    } else if (compareToSecond(key, "initialGuess"))
+    {
+      if (value.starts_with("Previous"))
+        settings->initialGuess = Settings::InitialGuess::Previous;
+      else if (value.starts_with("Linear"))
+        settings->initialGuess = Settings::InitialGuess::Linear;
+      else if (value.starts_with("Quadratic"))
+        settings->initialGuess = Settings::InitialGuess::Quadratic;
+      else
+        validLine = false;
+    } else if (compareToSecond(key, "pressureIncrement"))
+      settings->pressureIncrement = value.starts_with("true");
+    else if (compareToSecond(key, "mixedPrecision"))
+      settings->mixedPrecision = value.starts_with("true");
+    else if (compareToSecond(key, "coarseCorrection"))
+      settings->coarseCorrection = value.starts_with("true");
+    else if (compareToSecond(key, "amgStrength"))
+      settings->amgStrength = atof(value.c_str());
+    else if (compareToSecond(key, "blockJacobiSweeps"))
+      settings->blockJacobiSweeps = atoi(value.c_str());
+    else if (compareToSecond(key, "chebyshevDegree"))
+      settings->chebyshevDegree = atoi(value.c_str());
+    else if (compareToSecond(key, "sStepLength"))
+      settings->sStepLength = atoi(value.c_str());
+    else if (compareToSecond(key, "temporalBlocking"))
+      settings->temporalBlocking = atoi(value.c_str());
+    else if (compareToSecond(key, "threads"))
+      settings->threads = atoi(value.c_str());
+    else if (compareToSecond(key, "timeSlices"))
+      settings->timeSlices = atoi(value.c_str());
+    else if (compareToSecond(key, "pararealIterations"))
+      settings->pararealIterations = atoi(value.c_str());
+    else if (compareToSecond(key, "pararealCoarseTau"))
+      settings->pararealCoarseTau = atof(value.c_str());
+    else if (compareToSecond(key, "choleskyCache"))
+      settings->choleskyCache = value.substr(0, value.find_first_of(" \t#"));
+    else if (compareToSecond(key, "omega"))
+    {
+      // the adaptive SOR starts as gauss seidel and approaches the optimum from below
+      settings->adaptiveOmega = value.starts_with("auto");
+      settings->omega = settings->adaptiveOmega ? 1. : atof(value.c_str());
+    }
     else if (compareToSecond(key, "epsilon"))
       settings->epsilon = atof(value.c_str());
     else if (compareToSecond(key, "maximumNumberOfIterations"))
@@ -215,7 +316,13 @@ void Settings::printSettings() const
     "dirichletBcTop: " << dirichletBcTop[0] << "," << dirichletBcTop[1] << "\n"
     "dirichletBcLeft: " << dirichletBcLeft[0] << "," << dirichletBcLeft[1] << "\n"
     "dirichletBcRight: " << dirichletBcRight[0] << "," << dirichletBcRight[1] << "\n"
-    "pressureSolver: " ;
+    "threads: " << threads << "\n";
+  if (timeSlices > 1)
+    std::cout <<
+    "timeSlices: " << timeSlices << "\n"
+    "pararealIterations: " << pararealIterations << "\n"
+    "pararealCoarseTau: " << pararealCoarseTau << "\n";
+  std::cout << "pressureSolver: " ;
   switch (pressureSolver) {
     case SOR:
    std::cout << "SOR\n";
@@ -232,11 +339,64 @@ void Settings::printSettings() const
   case Jacoby:
    std::cout << "Jacoby\n";
     break;
+  case Multigrid:
+   std::cout << "Multigrid\n";
+    break;
+  case FFT:
+   std::cout << "FFT\n";
+    break;
+  case PipelinedCG:
+   std::cout << "PipelinedCG\n";
+    break;
+  case SStepCG:
+   std::cout << "SStepCG\n";
+    break;
+  case Chebyshev:
+   std::cout << "Chebyshev\n";
+    break;
+  case Zebra:
+   std::cout << "Zebra\n";
+    break;
+  case Cholesky:
+   std::cout << "Cholesky\n";
+    break;
   }
   std::cout <<
-    "omega: " << omega << "\n"
+    "omega: " << (adaptiveOmega ? "auto" : std::to_string(omega)) << "\n"
     "epsilon: " << epsilon << "\n"
-    "maximumNumberOfIterations: " << maximumNumberOfIterations << std::endl;
+    "maximumNumberOfIterations: " << maximumNumberOfIterations << "\n"
+    "initialGuess: " << (initialGuess == InitialGuess::Linear ? "Linear" : initialGuess == InitialGuess::Quadratic ? "Quadratic" : "Previous") << "\n"
+    "pressureIncrement: " << (pressureIncrement ? "true" : "false") << "\n";
+  if (pressureSolver == SOR)
+    std::cout << "mixedPrecision: " << (mixedPrecision ? "true" : "false") << "\n";
+  if (pressureSolver == CG || pressureSolver == PipelinedCG)
+    std::cout << "preconditioner: " << (preconditioner == Preconditioner::Multigrid ? "Multigrid" : preconditioner == Preconditioner::Chebyshev ? "Chebyshev" : preconditioner == Preconditioner::BlockJacobi ? "BlockJacobi"
+      : preconditioner == Preconditioner::SSOR ? "SSOR" : preconditioner == Preconditioner::IncompleteCholesky ? "IncompleteCholesky"
+      : preconditioner == Preconditioner::AMG ? "AMG" : "Jacobi") << "\n";
+  if (pressureSolver == CG)
+    std::cout << "coarseCorrection: " << (coarseCorrection ? "true" : "false") << "\n";
+  if ((pressureSolver == CG || pressureSolver == PipelinedCG) && preconditioner == Preconditioner::Chebyshev)
+    std::cout << "chebyshevDegree: " << chebyshevDegree << "\n";
+  if ((pressureSolver == CG || pressureSolver == PipelinedCG) && preconditioner == Preconditioner::BlockJacobi)
+    std::cout << "blockJacobiSweeps: " << blockJacobiSweeps << "\n";
+  if ((pressureSolver == CG || pressureSolver == PipelinedCG) && preconditioner == Preconditioner::AMG)
+    std::cout << "amgStrength: " << amgStrength << "\n";
+  if (pressureSolver == SStepCG)
+    std::cout << "sStepLength: " << sStepLength << "\n";
+  if (pressureSolver == Jacoby || pressureSolver == BlackRed)
+    std::cout << "temporalBlocking: " << temporalBlocking << "\n";
+  if (pressureSolver == Cholesky)
+    std::cout << "choleskyCache: " << choleskyCache.string() << "\n";
+  if (pressureSolver == Multigrid || preconditioner == Preconditioner::Multigrid)
+  {
+    std::cout <<
+    "multigridCycle: " << (multigridCycle == VCycle ? "V" : multigridCycle == WCycle ? "W" : "F") << "\n"
+    "multigridSmoother: " << (multigridSmoother == SOR ? "SOR" : multigridSmoother == Chebyshev ? "Chebyshev" : multigridSmoother == Zebra ? "Zebra" : "BlackRed") << "\n"
+    "multigridPreSmoothing: " << multigridPreSmoothing << "\n"
+    "multigridPostSmoothing: " << multigridPostSmoothing << "\n"
+    "multigridCoarseIterations: " << multigridCoarseIterations << "\n";
+  }
+  std::cout << std::endl;
     
 }
 // clang-format on
@@ -32,13 +32,68 @@ struct Settings
     CG,
     SOR,
     Jacoby,
-    GaussSeidel
+    GaussSeidel,
+    Multigrid,
+    FFT,
+    PipelinedCG,
+    SStepCG,
+    Chebyshev,
+    Zebra,
+    Cholesky
   };
   PressureSolver pressureSolver = SOR; //< which pressure solver to use, "GaussSeidel" or "SOR"
   double omega = 1.8; //< overrelaxation factor
+  bool adaptiveOmega = false; //< learn omega from the residual contraction, set by "omega = auto"
   double epsilon = 1e-4; //< tolerance for the residual in the pressure solver
   int maximumNumberOfIterations = 1e5; //< maximum number of iterations in the solver
 
+  enum MultigridCycle
+  {
+    VCycle,
+    WCycle,
+    FCycle
+  };
+  MultigridCycle multigridCycle = VCycle; //< cycle type of the multigrid solver, "V", "W" or "F"
+  PressureSolver multigridSmoother = BlackRed; //< smoother on every multigrid level, "BlackRed", "SOR", "Chebyshev" or "Zebra"
+  int multigridPreSmoothing = 2; //< number of smoothing sweeps before restriction
+  int multigridPostSmoothing = 2; //< number of smoothing sweeps after prolongation
+  int multigridCoarseIterations = 50; //< number of smoothing sweeps on the coarsest level
+
+  enum class Preconditioner
+  {
+    Jacobi,
+    Multigrid,
+    Chebyshev,
+    BlockJacobi,
+    SSOR,
+    IncompleteCholesky,
+    AMG
+  };
+  Preconditioner preconditioner = Preconditioner::Jacobi; //< preconditioner of the CG solver, "Jacobi", "Multigrid", "Chebyshev", "BlockJacobi", "SSOR", "IncompleteCholesky" or "AMG"
+  int chebyshevDegree = 4; //< iterations of the chebyshev preconditioner
+  int blockJacobiSweeps = 2; //< symmetric SOR sweeps of the rank local solves in the block jacobi preconditioner
+  double amgStrength = 0.08; //< couplings with |a_ij| >= amgStrength * sqrt(|a_ii a_jj|) are aggregated by the AMG preconditioner
+  bool coarseCorrection = false; //< add a coarse space correction with one unknown per rank to the CG preconditioner
+
+  enum class InitialGuess
+  {
+    Previous,
+    Linear,
+    Quadratic
+  };
+  InitialGuess initialGuess = InitialGuess::Previous; //< extrapolation of the pressure from the previous time steps, "Previous", "Linear" or "Quadratic"
+  bool pressureIncrement = false; //< solve for the increment to the initial guess instead of the pressure
+  bool mixedPrecision = false; //< SOR sweeps on single precision copies, refined in double precision
+
+  int sStepLength = 4; //< iterations per halo exchange and global reduction of the s-step CG solver
+  int temporalBlocking = 1; //< iterations of the Jacobi and BlackRed solvers per halo exchange and pass over the grid
+  int threads = 0; //< OpenMP threads of every rank, pinned to its share of the cores, 0 uses one per core of the share or OMP_NUM_THREADS
+  int timeSlices = 1; //< groups of ranks that advance consecutive parts of [0, endTime] with parareal, 1 steps sequentially
+  int pararealIterations = 2; //< parareal corrections of the time slices
+  double pararealCoarseTau = 0.8; //< safety factor of the coarse propagator, which steps on a grid with half the cells
+
+  std::filesystem::path choleskyCache; //< directory of the Cholesky factors, keyed by grid size and spacing, empty disables the cache
+
   Partitioning::MPIInfo mpi; //< information about the MPI partitioning
 
   //! parse a text file with settings, each line contains "<parameterName> = <value>"